@@ -1,223 +1,1697 @@
 #include <iostream>
-#include <list>
-#include <unordered_map>
+#include <functional>
+#include <vector>
 #include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <type_traits>
+#include <cmath>
+#include <stdexcept>
+#include <malloc.h>
 
-template <typename Key, typename Value>
+#include "expiry-wheel.h"
+#include "cache-snapshot.h"
+
+// 只保存键指纹的幽灵列表：环形数组按淘汰顺序(FIFO)存放指纹，
+// 另用一张开放寻址小表记录 指纹 -> 环中位置，用于 O(1) 判断命中和删除。
+// 命中后被删除的指纹在环中留作过期槽位，出队时按位置比对识别并跳过；
+// 环取两倍容量，写满时压缩掉过期槽位，均摊 O(1)
+template <typename FP>
+class GhostFifo {
+private:
+    struct Slot {
+        FP fp;         // 0 表示空槽
+        uint32_t pos;  // 指纹在环中的下标
+    };
+
+    size_t capacity;    // 最多保留的有效指纹数
+    std::vector<FP> ring;
+    uint64_t head = 0;  // 最旧槽位的序号
+    uint64_t tail = 0;  // 下一个写入的序号
+    std::vector<Slot> table;
+    size_t live = 0;
+
+    size_t find(FP fp) const {
+        size_t mask = table.size() - 1;
+        for (size_t i = static_cast<size_t>(fp) & mask; table[i].fp != 0; i = (i + 1) & mask) {
+            if (table[i].fp == fp) return i;
+        }
+        return SIZE_MAX;
+    }
+
+    // 线性探测的后移删除，不留墓碑
+    void eraseAt(size_t i) {
+        size_t mask = table.size() - 1;
+        for (size_t j = (i + 1) & mask; table[j].fp != 0; j = (j + 1) & mask) {
+            size_t k = static_cast<size_t>(table[j].fp) & mask;
+            bool stays = (i <= j) ? (i < k && k <= j) : (i < k || k <= j);
+            if (!stays) {
+                table[i] = table[j];
+                i = j;
+            }
+        }
+        table[i].fp = 0;
+        live--;
+    }
+
+    bool isLive(uint64_t seq) const {
+        uint32_t pos = static_cast<uint32_t>(seq % ring.size());
+        size_t i = find(ring[pos]);
+        return i != SIZE_MAX && table[i].pos == pos;
+    }
+
+    // 按原顺序只保留有效指纹，重新从环首排列
+    void compact() {
+        std::vector<FP> fresh(ring.size());
+        uint64_t n = 0;
+        for (uint64_t seq = head; seq < tail; seq++) {
+            if (isLive(seq)) fresh[n++] = ring[seq % ring.size()];
+        }
+        for (uint64_t i = 0; i < n; i++) {
+            table[find(fresh[i])].pos = static_cast<uint32_t>(i);
+        }
+        ring.swap(fresh);
+        head = 0;
+        tail = n;
+    }
+
+public:
+    explicit GhostFifo(size_t cap) : capacity(std::max<size_t>(cap, 1)), ring(2 * capacity) {
+        size_t n = 16;
+        while (n < 2 * capacity) n <<= 1;  // 装载率不超过 1/2
+        table.assign(n, Slot{0, 0});
+    }
+
+    size_t size() const { return live; }
+
+    bool contains(FP fp) const { return find(fp) != SIZE_MAX; }
+
+    bool erase(FP fp) {
+        size_t i = find(fp);
+        if (i == SIZE_MAX) return false;
+        eraseAt(i);
+        return true;
+    }
+
+    // 加入最新的指纹；有效指纹已满时挤掉最旧的一个
+    void push(FP fp) {
+        if (live == capacity) popOldest();
+        if (tail - head == ring.size()) compact();
+        uint32_t pos = static_cast<uint32_t>(tail++ % ring.size());
+        ring[pos] = fp;
+        size_t i = find(fp);
+        if (i != SIZE_MAX) {
+            table[i].pos = pos;  // 同一指纹再次入队，旧槽位随之过期
+            return;
+        }
+        size_t mask = table.size() - 1;
+        for (i = static_cast<size_t>(fp) & mask; table[i].fp != 0; i = (i + 1) & mask) {}
+        table[i] = Slot{fp, pos};
+        live++;
+    }
+
+    // 从旧到新遍历有效指纹
+    template <typename F>
+    void forEach(F&& f) const {
+        for (uint64_t seq = head; seq < tail; seq++) {
+            if (isLive(seq)) f(ring[seq % ring.size()]);
+        }
+    }
+
+    // 删除最旧的有效指纹
+    bool popOldest() {
+        while (head < tail) {
+            uint64_t seq = head++;
+            if (isLive(seq)) {
+                eraseAt(find(ring[seq % ring.size()]));
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+// ARC（自适应替换缓存）
+// 每个键只对应一个条目，条目同时挂在自实现的哈希桶链和所在列表(T1/T2/B1/B2)上，
+// 条目里记录所属列表，命中时不需要在列表里查找，每次操作只做一次哈希查找。
+// GhostFingerprint 为 uint32_t/uint64_t 时，B1/B2 不再保存完整 key，只在 GhostFifo
+// 中保存该宽度的 key 指纹，对大 key 可以省下大部分元数据内存；指纹冲突只会让
+// 极少数新 key 被误判为幽灵命中，影响 p 的调整，不影响正确性。
+// 传入 weigher 时容量按权重（例如字节数）计算：T1/T2 的淘汰、p 的调整和历史列表的
+// 上限都以权重为单位，权重为 0 的条目按 1 计，单个条目超过 maxEntryWeight 时直接拒绝缓存。
+// put 可以带 TTL：过期的条目在访问时惰性删除（直接丢弃，不进入历史列表），
+// 其余的由时间轮在 put 中每次推进一小段时主动清理；不使用 TTL 时 get 只多一次分支判断。
+// saveSnapshot/loadSnapshot 把驻留条目、历史列表和 p 存进文件再读回来，重启后不必重新预热
+template <typename Key, typename Value,
+          typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>,
+          typename GhostFingerprint = void>
 class ARCache {
+public:
+    // 运行统计
+    struct Stats {
+        uint64_t hits = 0;        // get 命中
+        uint64_t misses = 0;      // get 未命中
+        uint64_t b1GhostHits = 0; // put 命中 B1
+        uint64_t b2GhostHits = 0; // put 命中 B2
+        uint64_t rejected = 0;    // 超过单条目权重上限被拒绝的 put
+        uint64_t expired = 0;     // 因 TTL 到期被删除的条目
+        size_t p = 0;
+        size_t t1 = 0, t2 = 0, b1 = 0, b2 = 0;
+        size_t residentWeight = 0; // T1+T2 的总权重
+
+        Stats& operator+=(const Stats& o) {
+            hits += o.hits;
+            misses += o.misses;
+            b1GhostHits += o.b1GhostHits;
+            b2GhostHits += o.b2GhostHits;
+            rejected += o.rejected;
+            expired += o.expired;
+            p += o.p;
+            t1 += o.t1; t2 += o.t2; b1 += o.b1; b2 += o.b2;
+            residentWeight += o.residentWeight;
+            return *this;
+        }
+    };
+
+    // 条目权重函数，返回值与 capacity 同单位
+    using Weigher = std::function<size_t(const Key&, const Value&)>;
+
 private:
-    // 缓存容量
+    static constexpr bool kFingerprintGhosts = !std::is_void_v<GhostFingerprint>;
+    using FP = std::conditional_t<kFingerprintGhosts, GhostFingerprint, uint32_t>;
+
+    // 条目所在的列表
+    enum ListTag : uint8_t {
+        T1 = 0,  // 最近使用一次的页面
+        T2 = 1,  // 最近频繁使用的页面
+        B1 = 2,  // 从 T1 淘汰的页面历史（只保留 key）
+        B2 = 3,  // 从 T2 淘汰的页面历史（只保留 key）
+    };
+
+    // 嵌入在条目中的双向链表指针
+    struct Links {
+        Links* prev;
+        Links* next;
+    };
+
+    struct Entry : Links {
+        Key key;
+        Value value;
+        size_t hash;    // 缓存哈希值，扩容和删除时不必重新计算
+        Entry* hnext;   // 同一哈希桶中的下一个条目
+        size_t weight;  // 进入历史列表后保留原权重
+        uint64_t expireAt;  // 过期时间（ExpiryWheel::now() 的毫秒数），0 表示不过期
+        ListTag tag;    // 当前所在列表
+
+        Entry(const Key& k, const Value& v, size_t h, size_t w)
+            : key(k), value(v), hash(h), hnext(nullptr), weight(w), expireAt(0), tag(T1) {}
+    };
+
+    // 缓存容量（未设置 weigher 时为条目数）
     size_t capacity;
-    
-    // 适应性参数，用于调整 T1 和 T2 的大小
+    Weigher weigher;
+    size_t maxEntryWeight;
+
+    // 适应性参数，T1 的目标权重
     size_t p = 0;
-    
-    // 四个列表
-    std::list<Key> t1;  // 最近使用一次的页面
-    std::list<Key> t2;  // 最近频繁使用的页面
-    std::list<Key> b1;  // 从 T1 淘汰的页面历史
-    std::list<Key> b2;  // 从 T2 淘汰的页面历史
-    
-    // 哈希表用于快速查找和访问
-    std::unordered_map<Key, std::pair<Value, typename std::list<Key>::iterator>> cache;
-    std::unordered_map<Key, typename std::list<Key>::iterator> b1_map;
-    std::unordered_map<Key, typename std::list<Key>::iterator> b2_map;
-    
-    // 从列表中删除指定的键
-    void removeFromList(const Key& key, std::list<Key>& lst, 
-                        std::unordered_map<Key, typename std::list<Key>::iterator>& map) {
-        auto it = map.find(key);
-        if (it != map.end()) {
-            lst.erase(it->second);
-            map.erase(it);
-        }
-    }
-    
-    // 在列表头部添加键
-    void addToFront(const Key& key, std::list<Key>& lst, 
-                    std::unordered_map<Key, typename std::list<Key>::iterator>& map) {
-        lst.push_front(key);
-        map[key] = lst.begin();
-    }
-    
-    // 替换策略
-    void replace(const Key& key, int case_num) {
-        // 适应性调整参数 p
-        if (case_num == 3 && b1.size() >= b2.size()) {
-            p = std::min(p + 1, capacity);
-        } else if (case_num == 4 && b2.size() >= b1.size()) {
-            p = p > 0 ? p - 1 : 0;
-        }
-        
-        if (t1.size() >= 1 && ((t1.size() > p && (case_num == 3 || case_num == 4)) || 
-                               (t1.size() == p && case_num == 2))) {
-            // 从 T1 中淘汰
-            Key lru_key = t1.back();
-            t1.pop_back();
-            
-            // 将淘汰的页面添加到 B1
-            b1.push_front(lru_key);
-            b1_map[lru_key] = b1.begin();
-            
-            // 从缓存中移除
-            cache.erase(lru_key);
+
+    // 四个列表的哨兵，next 一端为 MRU，prev 一端为 LRU
+    Links lists[4];
+    size_t sizes[4] = {0, 0, 0, 0};
+    size_t weights[4] = {0, 0, 0, 0};
+
+    // 指纹模式下的 B1/B2
+    GhostFifo<FP> b1Ghosts;
+    GhostFifo<FP> b2Ghosts;
+
+    // 哈希表：桶数为 2 的幂，桶内单链表
+    std::vector<Entry*> buckets;
+    size_t entryCount = 0;
+    Hash hasher;
+    KeyEqual keyEqual;
+
+    // 带 TTL 条目的过期时间轮，每 kExpiryInterval 次 put 推进一次，每次最多检查 kExpiryBudget 条记录
+    static constexpr uint32_t kExpiryInterval = 16;
+    static constexpr size_t kExpiryBudget = 32;
+    ExpiryWheel<Key> expiry;
+    uint32_t expiryOps = 0;
+
+    uint64_t hits = 0, misses = 0, b1GhostHits = 0, b2GhostHits = 0, rejected = 0, expired = 0;
+
+    size_t hashOf(const Key& key) const {
+        // 再混合一次，避免 std::hash 对整数是恒等映射时低位分布差
+        uint64_t h = static_cast<uint64_t>(hasher(key)) * 0x9E3779B97F4A7C15ull;
+        return static_cast<size_t>(h ^ (h >> 32));
+    }
+
+    Entry* lookup(const Key& key, size_t h) const {
+        for (Entry* e = buckets[h & (buckets.size() - 1)]; e != nullptr; e = e->hnext) {
+            if (e->hash == h && keyEqual(e->key, key)) return e;
+        }
+        return nullptr;
+    }
+
+    void bucketInsert(Entry* e) {
+        if (entryCount >= buckets.size()) rehash(buckets.size() * 2);
+        Entry*& head = buckets[e->hash & (buckets.size() - 1)];
+        e->hnext = head;
+        head = e;
+        entryCount++;
+    }
+
+    void bucketErase(Entry* e) {
+        Entry** link = &buckets[e->hash & (buckets.size() - 1)];
+        while (*link != e) link = &(*link)->hnext;
+        *link = e->hnext;
+        entryCount--;
+    }
+
+    void rehash(size_t n) {
+        std::vector<Entry*> old(n, nullptr);
+        old.swap(buckets);
+        for (Entry* head : old) {
+            while (head != nullptr) {
+                Entry* next = head->hnext;
+                Entry*& slot = buckets[head->hash & (n - 1)];
+                head->hnext = slot;
+                slot = head;
+                head = next;
+            }
+        }
+    }
+
+    void unlink(Entry* e) {
+        e->prev->next = e->next;
+        e->next->prev = e->prev;
+        sizes[e->tag]--;
+        weights[e->tag] -= e->weight;
+    }
+
+    void pushFront(Entry* e, ListTag tag) {
+        Links& head = lists[tag];
+        e->prev = &head;
+        e->next = head.next;
+        head.next->prev = e;
+        head.next = e;
+        e->tag = tag;
+        sizes[tag]++;
+        weights[tag] += e->weight;
+    }
+
+    void moveToFront(Entry* e, ListTag tag) {
+        unlink(e);
+        pushFront(e, tag);
+    }
+
+    Entry* back(ListTag tag) {
+        return static_cast<Entry*>(lists[tag].prev);
+    }
+
+    // 彻底删除一个条目
+    void destroy(Entry* e) {
+        unlink(e);
+        bucketErase(e);
+        delete e;
+    }
+
+    static FP fingerprint(size_t h) {
+        FP fp = static_cast<FP>(static_cast<uint64_t>(h) >> (64 - 8 * sizeof(FP)));
+        return fp != 0 ? fp : 1;
+    }
+
+    size_t ghostSize(ListTag tag) const {
+        if constexpr (kFingerprintGhosts) {
+            return tag == B1 ? b1Ghosts.size() : b2Ghosts.size();
+        }
+        return sizes[tag];
+    }
+
+    // 指纹模式不支持权重，历史列表的权重就是条目数
+    size_t ghostWeight(ListTag tag) const {
+        if constexpr (kFingerprintGhosts) {
+            return ghostSize(tag);
+        }
+        return weights[tag];
+    }
+
+    size_t residentWeight() const {
+        return weights[T1] + weights[T2];
+    }
+
+    // 权重至少为 1：否则空值之类权重为 0 的条目不占容量、可以无限堆积，历史列表的权重也可能为 0
+    size_t weigh(const Key& key, const Value& value) const {
+        return weigher ? std::max<size_t>(weigher(key, value), 1) : 1;
+    }
+
+    // 把驻留页面降级到历史列表，值随之释放；指纹模式下条目本身也释放
+    void demote(Entry* victim, ListTag ghost) {
+        if constexpr (kFingerprintGhosts) {
+            (ghost == B1 ? b1Ghosts : b2Ghosts).push(fingerprint(victim->hash));
+            destroy(victim);
+        } else {
+            // 移动构造再析构才能真正释放缓冲区，直接赋空值时 std::string 等会保留容量
+            static_cast<void>(Value(std::move(victim->value)));
+            victim->value = Value{};
+            moveToFront(victim, ghost);
+        }
+    }
+
+    // 丢弃历史列表中最旧的记录
+    void dropOldestGhost(ListTag ghost) {
+        if constexpr (kFingerprintGhosts) {
+            (ghost == B1 ? b1Ghosts : b2Ghosts).popOldest();
         } else {
-            // 从 T2 中淘汰
-            Key lru_key = t2.back();
-            t2.pop_back();
-            
-            // 将淘汰的页面添加到 B2
-            b2.push_front(lru_key);
-            b2_map[lru_key] = b2.begin();
-            
-            // 从缓存中移除
-            cache.erase(lru_key);
-        }
-    }
-    
+            destroy(back(ghost));
+        }
+    }
+
+    // 替换策略：按 p 从 T1 或 T2 淘汰一个页面到对应的历史列表
+    void replace(bool hitInB2) {
+        if (sizes[T1] > 0 &&
+            (weights[T1] > p || (hitInB2 && weights[T1] == p) || sizes[T2] == 0)) {
+            demote(back(T1), B1);
+        } else {
+            demote(back(T2), B2);
+        }
+    }
+
+    // 腾出空间直到再放入权重为 w 的条目也不超过容量
+    void makeRoom(size_t w, bool hitInB2) {
+        while (sizes[T1] + sizes[T2] > 0 && residentWeight() + w > capacity) {
+            replace(hitInB2);
+        }
+    }
+
+    static bool isExpired(const Entry* e) {
+        return e->expireAt != 0 && e->expireAt <= ExpiryWheel<Key>::now();
+    }
+
+    // 过期处理都是冷路径，不内联进 get/put：命中路径上只要出现函数调用，
+    // get 就不再是叶子函数，每次都要建立栈帧，不用 TTL 时也会慢一成左右
+    __attribute__((noinline)) void expireEntry(Entry* e) {
+        expired++;
+        destroy(e);
+    }
+
+    // 已经过期时删除条目并返回 true
+    __attribute__((noinline)) bool expireIfDue(Entry* e) {
+        if (e->expireAt > ExpiryWheel<Key>::now()) return false;
+        expireEntry(e);
+        return true;
+    }
+
+    // 推进时间轮；只有截止时间仍然对得上的驻留条目才删除，其余是被更新或淘汰后留下的旧记录
+    __attribute__((noinline)) void advanceExpiry(size_t budget) {
+        expiry.advance(ExpiryWheel<Key>::now(), budget, [this](const Key& key, uint64_t deadline) {
+            Entry* e = lookup(key, hashOf(key));
+            if (e != nullptr && e->tag < B1 && e->expireAt == deadline) expireEntry(e);
+        });
+    }
+
+    void maintainExpiry() {
+        if (expiry.empty() || ++expiryOps < kExpiryInterval) return;
+        expiryOps = 0;
+        advanceExpiry(kExpiryBudget);
+    }
+
+    // 设置或更新缓存值，返回存放它的条目；被拒绝时返回 nullptr
+    Entry* store(const Key& key, const Value& value) {
+        if (capacity == 0) return nullptr;
+
+        size_t h = hashOf(key);
+        Entry* e = lookup(key, h);
+        int where = e != nullptr ? e->tag : -1;
+
+        size_t w = weigh(key, value);
+        if (w > maxEntryWeight) {
+            // 超大对象不准入；旧值已经过时，一并移出缓存
+            rejected++;
+            if (where == T1 || where == T2) destroy(e);
+            return nullptr;
+        }
+
+        if constexpr (kFingerprintGhosts) {
+            if (e == nullptr) {
+                FP fp = fingerprint(h);
+                if (b1Ghosts.contains(fp)) where = B1;
+                else if (b2Ghosts.contains(fp)) where = B2;
+            }
+        }
+
+        if (where >= 0) {
+            switch (where) {
+            case T1:
+            case T2:
+                // Case 1: 命中，更新值并移到 T2；先摘下自己，新值变大时不会淘汰到自己
+                unlink(e);
+                e->value = value;
+                e->weight = w;
+                makeRoom(w, false);
+                pushFront(e, T2);
+                return e;
+            case B1: {
+                // Case 2: 命中 B1，说明 T1 偏小，按新条目的权重增大 p
+                b1GhostHits++;
+                size_t b1 = ghostWeight(B1);
+                p = std::min(capacity, p + std::max<size_t>(b1 ? ghostWeight(B2) / b1 : 1, 1) * w);
+                break;
+            }
+            case B2: {
+                // Case 3: 命中 B2，说明 T2 偏小，减小 p
+                b2GhostHits++;
+                size_t b2 = ghostWeight(B2);
+                size_t delta = std::max<size_t>(b2 ? ghostWeight(B1) / b2 : 1, 1) * w;
+                p = p > delta ? p - delta : 0;
+                break;
+            }
+            }
+            // 先移出历史列表再替换，以免历史列表暂时超出容量
+            if constexpr (kFingerprintGhosts) {
+                (where == B1 ? b1Ghosts : b2Ghosts).erase(fingerprint(h));
+                makeRoom(w, where == B2);
+                e = new Entry(key, value, h, w);
+                bucketInsert(e);
+            } else {
+                unlink(e);
+                makeRoom(w, where == B2);
+                e->value = value;
+                e->weight = w;
+            }
+            pushFront(e, T2);
+            return e;
+        }
+
+        // Case 4: 新元素
+        if (weights[T1] + ghostWeight(B1) + w > capacity) {
+            // L1 = T1 + B1 已满，先清除 B1 最旧的历史条目
+            while (ghostSize(B1) > 0 && weights[T1] + ghostWeight(B1) + w > capacity) {
+                dropOldestGhost(B1);
+            }
+            // B1 为空且 T1 占满缓存，直接丢弃 T1 最旧的页面
+            while (sizes[T1] > 0 && weights[T1] + w > capacity) {
+                destroy(back(T1));
+            }
+        } else {
+            // 确保 B1 + B2 + T1 + T2 不超过 2 * capacity
+            while (ghostSize(B2) > 0 &&
+                   residentWeight() + ghostWeight(B1) + ghostWeight(B2) + w > 2 * capacity) {
+                dropOldestGhost(B2);
+            }
+        }
+        makeRoom(w, false);
+
+        e = new Entry(key, value, h, w);
+        bucketInsert(e);
+        pushFront(e, T1);
+        return e;
+    }
+
+    void deleteEntries() {
+        for (auto& l : lists) {
+            Links* cur = l.next;
+            while (cur != &l) {
+                Links* next = cur->next;
+                delete static_cast<Entry*>(cur);
+                cur = next;
+            }
+            l.prev = l.next = &l;
+        }
+    }
+
+    // 从 LRU 到 MRU 遍历一个列表
+    template <typename F>
+    void forEachFromLru(ListTag tag, F&& f) const {
+        for (const Links* cur = lists[tag].prev; cur != &lists[tag]; cur = cur->prev) {
+            f(static_cast<const Entry*>(cur));
+        }
+    }
+
+    // 快照里的历史列表格式：0 表示完整 key 加权重，否则为指纹的字节数
+    static constexpr uint8_t kGhostFormat = kFingerprintGhosts ? sizeof(FP) : 0;
+    static constexpr char kSnapshotMagic[9] = "ARCSNAP1";
+    static constexpr size_t kRestoreBatch = 32;
+
+    // 按 LRU 到 MRU 的顺序读入的条目逐个放到列表头部，读完后各列表的顺序与保存时相同
+    template <typename KeySerializer, typename ValueSerializer>
+    void restore(SnapshotReader& in, const KeySerializer& ks, const ValueSerializer& vs) {
+        uint64_t savedCapacity = in.get<uint64_t>();
+        uint64_t savedP = in.get<uint64_t>();
+        if (in.get<uint8_t>() != kGhostFormat) {
+            throw std::runtime_error("snapshot ghost format does not match this cache");
+        }
+        bool withTtl = in.get<uint8_t>() != 0;
+        uint64_t elapsed = in.elapsedMs();
+        uint64_t now = ExpiryWheel<Key>::now();
+        Key key{};
+        Value value{};
+
+        // 哈希桶是随机访问，逐个插入时几乎每个条目都要等一次内存；先解析一批、预取它们的桶再插入
+        Entry* batch[kRestoreBatch];
+        size_t batched = 0;
+        auto flush = [&](ListTag tag) {
+            // 桶已经预取过，再预取桶里的第一个条目，查重时要比较它的哈希值
+            for (size_t i = 0; i < batched; i++) {
+                if (Entry* head = buckets[batch[i]->hash & (buckets.size() - 1)]) __builtin_prefetch(head);
+            }
+            for (size_t i = 0; i < batched; i++) {
+                Entry* e = batch[i];
+                if (lookup(e->key, e->hash) != nullptr) {
+                    for (size_t j = i; j < batched; j++) delete batch[j];
+                    batched = 0;
+                    throw std::runtime_error("corrupt snapshot: duplicate key");
+                }
+                bucketInsert(e);
+                pushFront(e, tag);
+                if (e->expireAt != 0) expiry.schedule(e->key, e->expireAt);
+            }
+            batched = 0;
+        };
+        auto add = [&](ListTag tag, Entry* e) {
+            __builtin_prefetch(&buckets[e->hash & (buckets.size() - 1)]);
+            batch[batched++] = e;
+            if (batched == kRestoreBatch) flush(tag);
+        };
+
+        try {
+            for (ListTag tag : {T1, T2}) {
+                uint64_t n = in.count();
+                for (uint64_t i = 0; i < n; i++) {
+                    ks.read(in, key);
+                    vs.read(in, value);
+                    uint64_t remaining = withTtl ? in.get<uint64_t>() : 0;
+                    if (remaining != 0 && remaining <= elapsed) continue;  // 停机期间已经过期
+                    size_t w = weigh(key, value);
+                    if (w > maxEntryWeight) continue;
+                    Entry* e = new Entry(key, value, hashOf(key), w);
+                    if (remaining != 0) e->expireAt = now + remaining - elapsed;
+                    add(tag, e);
+                }
+                flush(tag);
+            }
+            value = Value{};
+            for (ListTag tag : {B1, B2}) {
+                uint64_t n = in.count();
+                for (uint64_t i = 0; i < n; i++) {
+                    if constexpr (kFingerprintGhosts) {
+                        (tag == B1 ? b1Ghosts : b2Ghosts).push(in.get<FP>());
+                    } else {
+                        ks.read(in, key);
+                        // 旧快照里可能有权重为 0 的历史条目
+                        size_t w = std::max<size_t>(static_cast<size_t>(in.get<uint64_t>()), 1);
+                        add(tag, new Entry(key, value, hashOf(key), w));
+                    }
+                }
+                flush(tag);
+            }
+        } catch (...) {
+            for (size_t i = 0; i < batched; i++) delete batch[i];
+            throw;
+        }
+        in.finish();
+
+        // 容量变了就按比例换算 p，再按 ARC 的规则收缩到新容量
+        p = savedCapacity == capacity || savedCapacity == 0
+            ? savedP : static_cast<size_t>(static_cast<double>(savedP) * capacity / savedCapacity);
+        p = std::min(p, capacity);
+        makeRoom(0, false);
+        while (ghostSize(B1) > 0 && weights[T1] + ghostWeight(B1) > capacity) {
+            dropOldestGhost(B1);
+        }
+        while (ghostSize(B2) > 0 && residentWeight() + ghostWeight(B1) + ghostWeight(B2) > 2 * capacity) {
+            dropOldestGhost(B2);
+        }
+    }
+
 public:
-    ARCache(size_t size) : capacity(size) {}
-    
+    // maxEntryWeight 为 0 表示不超过整个容量即可
+    ARCache(size_t size, Weigher w = nullptr, size_t maxWeight = 0)
+        : capacity(size),
+          weigher(std::move(w)),
+          maxEntryWeight(maxWeight == 0 ? size : std::min(maxWeight, size)),
+          b1Ghosts(kFingerprintGhosts ? size : 0),
+          b2Ghosts(kFingerprintGhosts ? size : 0) {
+        if (kFingerprintGhosts && weigher) {
+            throw std::invalid_argument("fingerprint ghosts do not support weighted capacity");
+        }
+        for (auto& l : lists) {
+            l.prev = l.next = &l;
+        }
+        // T1+T2+B1+B2 最多 2*capacity 个条目（指纹模式下哈希表只放 T1+T2），
+        // 按此预留桶，稳定后不再扩容；按权重计容量时条目数未知，按需扩容
+        size_t n = 16;
+        while (!weigher && n < (kFingerprintGhosts ? 1 : 2) * capacity) n <<= 1;
+        buckets.assign(n, nullptr);
+    }
+
+    ~ARCache() {
+        deleteEntries();
+    }
+
+    ARCache(const ARCache&) = delete;
+    ARCache& operator=(const ARCache&) = delete;
+
+    // 获取缓存值，命中返回 true；命中的条目移到 T2 头部
+    bool get(const Key& key, Value& value) {
+        Entry* e = lookup(key, hashOf(key));
+        if (e == nullptr || e->tag >= B1 || (e->expireAt != 0 && expireIfDue(e))) {
+            misses++;
+            return false;
+        }
+        hits++;
+        moveToFront(e, T2);
+        value = e->value;
+        return true;
+    }
+
+    // 只读查找，不调整列表位置也不计入统计，可在共享锁下并发调用
+    bool peek(const Key& key, Value& value) const {
+        Entry* e = lookup(key, hashOf(key));
+        if (e == nullptr || e->tag >= B1 || isExpired(e)) {
+            return false;
+        }
+        value = e->value;
+        return true;
+    }
+
+    // 补记一次命中（配合 peek 延迟回放），条目已被淘汰时忽略
+    void touch(const Key& key) {
+        Entry* e = lookup(key, hashOf(key));
+        if (e != nullptr && e->tag < B1 && !(e->expireAt != 0 && expireIfDue(e))) {
+            hits++;
+            moveToFront(e, T2);
+        }
+    }
+
     // 获取缓存值，如果不存在返回默认构造的值
     Value get(const Key& key) {
-        auto it = cache.find(key);
-        if (it == cache.end()) {
-            return Value{};
-        }
-        
-        // 从当前位置移除
-        if (b1_map.find(key) != b1_map.end()) {
-            // Case 3: 在 B1 中 - 提升到 T2
-            removeFromList(key, b1, b1_map);
-            t2.push_front(key);
-            it->second.second = t2.begin();
-        } else if (b2_map.find(key) != b2_map.end()) {
-            // Case 4: 在 B2 中 - 提升到 T2
-            removeFromList(key, b2, b2_map);
-            t2.push_front(key);
-            it->second.second = t2.begin();
-        } else if (std::find(t1.begin(), t1.end(), key) != t1.end()) {
-            // 从 T1 移动到 T2
-            t1.erase(it->second.second);
-            t2.push_front(key);
-            it->second.second = t2.begin();
-        } else {
-            // 已经在 T2 中，只需移到前面
-            t2.erase(it->second.second);
-            t2.push_front(key);
-            it->second.second = t2.begin();
+        Value value{};
+        get(key, value);
+        return value;
+    }
+
+    // 设置或更新缓存值，不过期；覆盖带 TTL 的旧值时取消它的过期时间
+    void put(const Key& key, const Value& value) {
+        maintainExpiry();
+        if (Entry* e = store(key, value)) e->expireAt = 0;
+    }
+
+    // 设置或更新缓存值，ttl 之后过期
+    void put(const Key& key, const Value& value, std::chrono::milliseconds ttl) {
+        maintainExpiry();
+        Entry* e = store(key, value);
+        if (e == nullptr) return;
+        // 截止时间 0 保留给“不过期”；ttl 不大于 0 时下次访问即过期
+        e->expireAt = std::max<uint64_t>(ExpiryWheel<Key>::now() + std::max<int64_t>(ttl.count(), 0), 1);
+        expiry.schedule(key, e->expireAt);
+        // 被更新或淘汰的条目在时间轮里留下旧记录，超过有效条目两倍时清理一次
+        if (expiry.size() > 2 * size() + 1024) {
+            expiry.compact([this](const Key& k, uint64_t deadline) {
+                Entry* x = lookup(k, hashOf(k));
+                return x != nullptr && x->tag < B1 && x->expireAt == deadline;
+            });
         }
-        
-        return it->second.first;
     }
-    
+
+    // 立即删除已经过期的条目，返回删除的个数；精度为时间轮的一个 tick，刚过期的条目可能留到下一个 tick
+    size_t removeExpired() {
+        uint64_t before = expired;
+        advanceExpiry(SIZE_MAX);
+        return static_cast<size_t>(expired - before);
+    }
+
+    // 检查键是否存在于缓存中
+    bool contains(const Key& key) const {
+        Entry* e = lookup(key, hashOf(key));
+        return e != nullptr && e->tag < B1 && !isExpired(e);
+    }
+
+    // 返回缓存当前大小，包含已过期但还没被清理的条目
+    size_t size() const {
+        return sizes[T1] + sizes[T2];
+    }
+
+    Stats stats() const {
+        Stats st;
+        st.hits = hits;
+        st.misses = misses;
+        st.b1GhostHits = b1GhostHits;
+        st.b2GhostHits = b2GhostHits;
+        st.rejected = rejected;
+        st.expired = expired;
+        st.residentWeight = residentWeight();
+        st.p = p;
+        st.t1 = sizes[T1]; st.t2 = sizes[T2]; st.b1 = ghostSize(B1); st.b2 = ghostSize(B2);
+        return st;
+    }
+
+    // 清空缓存，包括历史列表、p 和过期记录；统计计数保留
+    void clear() {
+        deleteEntries();
+        std::fill(std::begin(sizes), std::end(sizes), 0);
+        std::fill(std::begin(weights), std::end(weights), 0);
+        std::fill(buckets.begin(), buckets.end(), nullptr);
+        entryCount = 0;
+        p = 0;
+        if constexpr (kFingerprintGhosts) {
+            b1Ghosts = GhostFifo<FP>(capacity);
+            b2Ghosts = GhostFifo<FP>(capacity);
+        }
+        expiry = ExpiryWheel<Key>();
+        expiryOps = 0;
+    }
+
+    // 把 p、T1/T2 的条目和 B1/B2 的历史写入快照文件，每个列表从 LRU 到 MRU 写出，已经过期的条目不写。
+    // key/value 的序列化器可以替换，默认支持平凡可复制类型和 std::string
+    template <typename KeySerializer = SnapshotSerializer<Key>,
+              typename ValueSerializer = SnapshotSerializer<Value>>
+    void saveSnapshot(const std::string& path, const KeySerializer& ks = KeySerializer(),
+                      const ValueSerializer& vs = ValueSerializer()) const {
+        SnapshotWriter out(path, kSnapshotMagic);
+        uint64_t now = ExpiryWheel<Key>::now();
+        out.put<uint64_t>(capacity);
+        out.put<uint64_t>(p);
+        out.put(kGhostFormat);
+        // 没有带 TTL 的条目时不写剩余时间，每个条目省 8 字节；带 TTL 的驻留条目在时间轮里一定有记录
+        bool withTtl = !expiry.empty();
+        out.put<uint8_t>(withTtl);
+        for (ListTag tag : {T1, T2}) {
+            uint64_t at = out.reserve<uint64_t>();
+            uint64_t n = 0;
+            forEachFromLru(tag, [&](const Entry* e) {
+                if (e->expireAt != 0 && e->expireAt <= now) return;
+                ks.write(out, e->key);
+                vs.write(out, e->value);
+                if (withTtl) out.put<uint64_t>(e->expireAt == 0 ? 0 : e->expireAt - now);
+                n++;
+            });
+            out.patch(at, n);
+        }
+        for (ListTag tag : {B1, B2}) {
+            if constexpr (kFingerprintGhosts) {
+                const GhostFifo<FP>& ghosts = tag == B1 ? b1Ghosts : b2Ghosts;
+                out.put<uint64_t>(ghosts.size());
+                ghosts.forEach([&](FP fp) { out.put(fp); });
+            } else {
+                out.put<uint64_t>(sizes[tag]);
+                forEachFromLru(tag, [&](const Entry* e) {
+                    ks.write(out, e->key);
+                    out.put<uint64_t>(e->weight);
+                });
+            }
+        }
+        out.commit();
+    }
+
+    // 用快照文件的内容替换当前缓存。容量与保存时不同时按比例换算 p，多出的条目按 ARC 的规则淘汰；
+    // 停机期间 TTL 已经耗尽的条目丢弃。文件打不开或文件头不对时抛出 std::runtime_error，缓存不变；
+    // 内容在解析中途出错时同样抛出，缓存留空
+    template <typename KeySerializer = SnapshotSerializer<Key>,
+              typename ValueSerializer = SnapshotSerializer<Value>>
+    void loadSnapshot(const std::string& path, const KeySerializer& ks = KeySerializer(),
+                      const ValueSerializer& vs = ValueSerializer()) {
+        SnapshotReader in(path, kSnapshotMagic);
+        clear();
+        try {
+            restore(in, ks, vs);
+        } catch (...) {
+            clear();
+            throw;
+        }
+    }
+
+    // 显示当前状态信息
+    void printStatus() {
+        std::cout << "ARC Status:" << std::endl;
+        std::cout << "p = " << p << std::endl;
+        std::cout << "T1 size: " << sizes[T1] << ", T2 size: " << sizes[T2] << std::endl;
+        std::cout << "B1 size: " << ghostSize(B1) << ", B2 size: " << ghostSize(B2) << std::endl;
+        if (weigher) {
+            std::cout << "T1 weight: " << weights[T1] << ", T2 weight: " << weights[T2]
+                      << ", capacity: " << capacity << std::endl;
+        }
+    }
+};
+
+// 线程安全的分片 ARC：key 哈希到 N 个独立的 ARCache 分片，每个分片有自己的锁和自适应参数 p。
+// bufferedReads 打开时，读路径只拿分片的共享锁做 peek，命中的 key 记到按线程条带化的缓冲里，
+// 攒满一批后再在独占锁下回放到 ARC 列表，读操作因此不再争抢写锁
+template <typename Key, typename Value,
+          typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>,
+          typename GhostFingerprint = void>
+class ShardedARCache {
+private:
+    using ShardCache = ARCache<Key, Value, Hash, KeyEqual, GhostFingerprint>;
+
+    static constexpr size_t kReadStripes = 16;     // 每个分片的命中缓冲条带数
+    static constexpr size_t kReadBatch = 32;       // 攒满多少次命中回放一次
+
+    struct ReadBuffer {
+        std::mutex mtx;
+        std::vector<Key> keys;
+    };
+
+    struct Shard {
+        std::shared_mutex mtx;
+        ShardCache cache;
+        ReadBuffer buffers[kReadStripes];
+        std::atomic<uint64_t> bufferedMisses{0};  // 缓冲读路径上的未命中，ARCache 自身看不到
+
+        Shard(size_t capacity, typename ShardCache::Weigher weigher, size_t maxEntryWeight)
+            : cache(capacity, std::move(weigher), maxEntryWeight) {}
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    size_t shardMask;
+    bool bufferedReads;
+    Hash hasher;
+
+    Shard& shardFor(const Key& key) {
+        // 与分片内哈希表使用不同的混合常数，用高位选分片
+        uint64_t h = static_cast<uint64_t>(hasher(key)) * 0xC2B2AE3D27D4EB4Full;
+        return *shards[(h >> 40) & shardMask];
+    }
+
+    static size_t stripeIndex() {
+        thread_local size_t idx = std::hash<std::thread::id>{}(std::this_thread::get_id()) % kReadStripes;
+        return idx;
+    }
+
+    // 调用方持有分片独占锁；拿不到条带锁的缓冲留给下一次
+    void drainBuffers(Shard& shard) {
+        for (auto& buf : shard.buffers) {
+            std::unique_lock<std::mutex> guard(buf.mtx, std::try_to_lock);
+            if (!guard.owns_lock()) continue;
+            for (const Key& k : buf.keys) shard.cache.touch(k);
+            buf.keys.clear();
+        }
+    }
+
+public:
+    // capacity 为所有分片的总容量（设置 weigher 时为总权重）；shardCount 向上取整到 2 的幂
+    ShardedARCache(size_t capacity, size_t shardCount = 16, bool buffered = false,
+                   typename ShardCache::Weigher weigher = nullptr, size_t maxEntryWeight = 0)
+        : bufferedReads(buffered) {
+        size_t n = 1;
+        while (n < shardCount) n <<= 1;
+        shardMask = n - 1;
+        for (size_t i = 0; i < n; i++) {
+            shards.push_back(std::make_unique<Shard>(capacity / n + (i < capacity % n ? 1 : 0),
+                                                     weigher, maxEntryWeight));
+        }
+    }
+
+    bool get(const Key& key, Value& value) {
+        Shard& shard = shardFor(key);
+        if (!bufferedReads) {
+            std::unique_lock<std::shared_mutex> lock(shard.mtx);
+            return shard.cache.get(key, value);
+        }
+
+        {
+            std::shared_lock<std::shared_mutex> lock(shard.mtx);
+            if (!shard.cache.peek(key, value)) {
+                shard.bufferedMisses.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+        }
+
+        std::vector<Key> pending;
+        ReadBuffer& buf = shard.buffers[stripeIndex()];
+        {
+            std::lock_guard<std::mutex> guard(buf.mtx);
+            buf.keys.push_back(key);
+            if (buf.keys.size() < kReadBatch) return true;
+            pending.swap(buf.keys);
+            buf.keys.reserve(kReadBatch);
+        }
+        std::unique_lock<std::shared_mutex> lock(shard.mtx);
+        for (const Key& k : pending) shard.cache.touch(k);
+        return true;
+    }
+
+    void put(const Key& key, const Value& value) {
+        Shard& shard = shardFor(key);
+        std::unique_lock<std::shared_mutex> lock(shard.mtx);
+        // 先回放积压的命中，让淘汰决策尽量基于最新的访问顺序
+        if (bufferedReads) drainBuffers(shard);
+        shard.cache.put(key, value);
+    }
+
+    void put(const Key& key, const Value& value, std::chrono::milliseconds ttl) {
+        Shard& shard = shardFor(key);
+        std::unique_lock<std::shared_mutex> lock(shard.mtx);
+        if (bufferedReads) drainBuffers(shard);
+        shard.cache.put(key, value, ttl);
+    }
+
+    bool contains(const Key& key) {
+        Shard& shard = shardFor(key);
+        std::shared_lock<std::shared_mutex> lock(shard.mtx);
+        return shard.cache.contains(key);
+    }
+
+    size_t size() {
+        size_t total = 0;
+        for (auto& shard : shards) {
+            std::shared_lock<std::shared_mutex> lock(shard->mtx);
+            total += shard->cache.size();
+        }
+        return total;
+    }
+
+    // 回放所有分片中缓冲的命中
+    void flushReadBuffers() {
+        for (auto& shard : shards) {
+            std::unique_lock<std::shared_mutex> lock(shard->mtx);
+            drainBuffers(*shard);
+        }
+    }
+
+    // 汇总所有分片的统计，p 为各分片 p 之和；缓冲中尚未回放的命中不计入
+    typename ShardCache::Stats stats() {
+        typename ShardCache::Stats total;
+        for (auto& shard : shards) {
+            std::shared_lock<std::shared_mutex> lock(shard->mtx);
+            total += shard->cache.stats();
+            total.misses += shard->bufferedMisses.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    size_t shardCount() const { return shards.size(); }
+};
+
+// CAR（Clock with Adaptive Replacement）：与 ARCache 接口相同，T1/T2 换成两个时钟。
+// 命中只置位条目的引用位，不改动任何链表，读路径因此可以在共享锁下并发执行；
+// 未命中需要淘汰时，时钟指针扫过引用位为 1 的页面，清零后把它挪到 T2 尾部（T1 的页面借此升级），
+// 遇到引用位为 0 的页面才淘汰到 B1/B2。B1/B2 和 p 的自适应规则与 ARC 相同
+template <typename Key, typename Value,
+          typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+class CARCache {
+public:
+    // 运行统计
+    struct Stats {
+        uint64_t hits = 0;        // get 命中
+        uint64_t misses = 0;      // get 未命中
+        uint64_t b1GhostHits = 0; // put 命中 B1
+        uint64_t b2GhostHits = 0; // put 命中 B2
+        size_t p = 0;
+        size_t t1 = 0, t2 = 0, b1 = 0, b2 = 0;
+    };
+
+private:
+    // 条目所在的列表
+    enum ListTag : uint8_t {
+        T1 = 0,  // 时钟：最近使用一次的页面
+        T2 = 1,  // 时钟：至少使用两次的页面
+        B1 = 2,  // 从 T1 淘汰的页面历史（只保留 key）
+        B2 = 3,  // 从 T2 淘汰的页面历史（只保留 key）
+    };
+
+    // 嵌入在条目中的双向链表指针；哨兵的 next 为表头（时钟指针 / LRU 端），prev 为表尾
+    struct Links {
+        Links* prev;
+        Links* next;
+    };
+
+    struct Entry : Links {
+        Key key;
+        Value value;
+        size_t hash;
+        Entry* hnext;
+        ListTag tag;
+        // 引用位，多个读者并发置位，用 relaxed 原子避免数据竞争
+        std::atomic<bool> referenced;
+
+        Entry(const Key& k, const Value& v, size_t h)
+            : key(k), value(v), hash(h), hnext(nullptr), tag(T1), referenced(false) {}
+    };
+
+    size_t capacity;
+    size_t p = 0;
+
+    Links lists[4];
+    size_t sizes[4] = {0, 0, 0, 0};
+
+    std::vector<Entry*> buckets;
+    size_t entryCount = 0;
+    Hash hasher;
+    KeyEqual keyEqual;
+
+    uint64_t hits = 0, misses = 0, b1GhostHits = 0, b2GhostHits = 0;
+
+    size_t hashOf(const Key& key) const {
+        uint64_t h = static_cast<uint64_t>(hasher(key)) * 0x9E3779B97F4A7C15ull;
+        return static_cast<size_t>(h ^ (h >> 32));
+    }
+
+    Entry* lookup(const Key& key, size_t h) const {
+        for (Entry* e = buckets[h & (buckets.size() - 1)]; e != nullptr; e = e->hnext) {
+            if (e->hash == h && keyEqual(e->key, key)) return e;
+        }
+        return nullptr;
+    }
+
+    void bucketInsert(Entry* e) {
+        Entry*& head = buckets[e->hash & (buckets.size() - 1)];
+        e->hnext = head;
+        head = e;
+        entryCount++;
+    }
+
+    void bucketErase(Entry* e) {
+        Entry** link = &buckets[e->hash & (buckets.size() - 1)];
+        while (*link != e) link = &(*link)->hnext;
+        *link = e->hnext;
+        entryCount--;
+    }
+
+    void unlink(Entry* e) {
+        e->prev->next = e->next;
+        e->next->prev = e->prev;
+        sizes[e->tag]--;
+    }
+
+    void pushBack(Entry* e, ListTag tag) {
+        Links& head = lists[tag];
+        e->next = &head;
+        e->prev = head.prev;
+        head.prev->next = e;
+        head.prev = e;
+        e->tag = tag;
+        sizes[tag]++;
+    }
+
+    void moveToBack(Entry* e, ListTag tag) {
+        unlink(e);
+        pushBack(e, tag);
+    }
+
+    Entry* front(ListTag tag) {
+        return static_cast<Entry*>(lists[tag].next);
+    }
+
+    void destroy(Entry* e) {
+        unlink(e);
+        bucketErase(e);
+        delete e;
+    }
+
+    // 把驻留页面降级到历史列表的 MRU 端，值随之释放
+    void demote(Entry* victim, ListTag ghost) {
+        static_cast<void>(Value(std::move(victim->value)));
+        victim->value = Value{};
+        moveToBack(victim, ghost);
+    }
+
+    // 转动时钟直到淘汰一个引用位为 0 的页面；每个页面最多被跳过一次，循环有界
+    void replace() {
+        while (true) {
+            if (sizes[T1] >= std::max<size_t>(p, 1)) {
+                Entry* e = front(T1);
+                if (!e->referenced.load(std::memory_order_relaxed)) {
+                    demote(e, B1);
+                    return;
+                }
+                e->referenced.store(false, std::memory_order_relaxed);
+                moveToBack(e, T2);
+            } else {
+                Entry* e = front(T2);
+                if (!e->referenced.load(std::memory_order_relaxed)) {
+                    demote(e, B2);
+                    return;
+                }
+                e->referenced.store(false, std::memory_order_relaxed);
+                moveToBack(e, T2);
+            }
+        }
+    }
+
+    // 置位引用位；已置位时不写，避免多个读者反复弄脏同一缓存行
+    static void reference(Entry* e) {
+        if (!e->referenced.load(std::memory_order_relaxed)) {
+            e->referenced.store(true, std::memory_order_relaxed);
+        }
+    }
+
+public:
+    CARCache(size_t size) : capacity(size) {
+        for (auto& l : lists) {
+            l.prev = l.next = &l;
+        }
+        // T1+T2+B1+B2 不超过 2*capacity，桶数一次分配到位
+        size_t n = 16;
+        while (n < 2 * capacity) n <<= 1;
+        buckets.assign(n, nullptr);
+    }
+
+    ~CARCache() {
+        for (auto& l : lists) {
+            Links* cur = l.next;
+            while (cur != &l) {
+                Links* next = cur->next;
+                delete static_cast<Entry*>(cur);
+                cur = next;
+            }
+        }
+    }
+
+    CARCache(const CARCache&) = delete;
+    CARCache& operator=(const CARCache&) = delete;
+
+    // 获取缓存值，命中返回 true；命中只置位引用位
+    bool get(const Key& key, Value& value) {
+        Entry* e = lookup(key, hashOf(key));
+        if (e == nullptr || e->tag >= B1) {
+            misses++;
+            return false;
+        }
+        hits++;
+        reference(e);
+        value = e->value;
+        return true;
+    }
+
+    // 与 get 相同但不计入统计，不修改任何非原子状态，可在共享锁下并发调用
+    bool sharedGet(const Key& key, Value& value) const {
+        Entry* e = lookup(key, hashOf(key));
+        if (e == nullptr || e->tag >= B1) {
+            return false;
+        }
+        reference(e);
+        value = e->value;
+        return true;
+    }
+
+    // 只读查找，不置位引用位也不计入统计
+    bool peek(const Key& key, Value& value) const {
+        Entry* e = lookup(key, hashOf(key));
+        if (e == nullptr || e->tag >= B1) {
+            return false;
+        }
+        value = e->value;
+        return true;
+    }
+
+    // 补记一次命中，条目已被淘汰时忽略
+    void touch(const Key& key) {
+        Entry* e = lookup(key, hashOf(key));
+        if (e != nullptr && e->tag < B1) {
+            hits++;
+            reference(e);
+        }
+    }
+
+    // 获取缓存值，如果不存在返回默认构造的值
+    Value get(const Key& key) {
+        Value value{};
+        get(key, value);
+        return value;
+    }
+
     // 设置或更新缓存值
     void put(const Key& key, const Value& value) {
-        // 检查是否已经在缓存中
-        if (cache.find(key) != cache.end()) {
-            // 更新值并移动
-            cache[key].first = value;
-            get(key);  // 使用 get 来更新位置
+        if (capacity == 0) return;
+
+        size_t h = hashOf(key);
+        Entry* e = lookup(key, h);
+        if (e != nullptr && e->tag < B1) {
+            // 命中：更新值并置位引用位
+            e->value = value;
+            reference(e);
             return;
         }
-        
-        // 检查缓存是否已满
-        if (t1.size() + t2.size() >= capacity) {
-            // 需要替换
-            int case_num = 1;
-            
-            // 确定情况
-            if (b1_map.find(key) != b1_map.end()) {
-                case_num = 3;
-            } else if (b2_map.find(key) != b2_map.end()) {
-                case_num = 4;
-            }
-            
-            replace(key, case_num);
-        }
-        
-        // 确定在哪个列表中放置新元素
-        if (b1_map.find(key) != b1_map.end()) {
-            // Case 3: 在 B1 中
-            p = std::min(p + 1, capacity);
-            removeFromList(key, b1, b1_map);
-            t2.push_front(key);
-            cache[key] = {value, t2.begin()};
-        } else if (b2_map.find(key) != b2_map.end()) {
-            // Case 4: 在 B2 中
-            p = p > 0 ? p - 1 : 0;
-            removeFromList(key, b2, b2_map);
-            t2.push_front(key);
-            cache[key] = {value, t2.begin()};
-        } else {
-            // Case 1: 新元素
-            if (b1.size() + t1.size() >= capacity) {
-                // B1 已满，清除最旧的条目
-                if (b1.size() > 0) {
-                    Key lru = b1.back();
-                    b1.pop_back();
-                    b1_map.erase(lru);
+
+        bool ghost = e != nullptr;
+        if (sizes[T1] + sizes[T2] == capacity) {
+            replace();
+            // 新 key 进入前保证 T1+B1 <= c、总数 <= 2c
+            if (!ghost) {
+                if (sizes[T1] + sizes[B1] == capacity && sizes[B1] > 0) {
+                    destroy(front(B1));
+                } else if (sizes[T1] + sizes[T2] + sizes[B1] + sizes[B2] == 2 * capacity && sizes[B2] > 0) {
+                    destroy(front(B2));
                 }
             }
-            
-            // 添加到 T1
-            t1.push_front(key);
-            cache[key] = {value, t1.begin()};
-        }
-        
-        // 确保 B1 + B2 不超过缓存容量
-        while (b1.size() + b2.size() > capacity) {
-            if (b1.size() > b2.size()) {
-                Key lru = b1.back();
-                b1.pop_back();
-                b1_map.erase(lru);
-            } else {
-                Key lru = b2.back();
-                b2.pop_back();
-                b2_map.erase(lru);
-            }
         }
+
+        if (!ghost) {
+            e = new Entry(key, value, h);
+            bucketInsert(e);
+            pushBack(e, T1);
+            return;
+        }
+        if (e->tag == B1) {
+            // 命中 B1，说明 T1 偏小，增大 p
+            b1GhostHits++;
+            p = std::min(capacity, p + std::max<size_t>(sizes[B2] / sizes[B1], 1));
+        } else {
+            // 命中 B2，说明 T2 偏小，减小 p
+            b2GhostHits++;
+            size_t delta = std::max<size_t>(sizes[B1] / sizes[B2], 1);
+            p = p > delta ? p - delta : 0;
+        }
+        e->value = value;
+        e->referenced.store(false, std::memory_order_relaxed);
+        moveToBack(e, T2);
     }
-    
+
     // 检查键是否存在于缓存中
-    bool contains(const Key& key) {
-        return cache.find(key) != cache.end();
+    bool contains(const Key& key) const {
+        Entry* e = lookup(key, hashOf(key));
+        return e != nullptr && e->tag < B1;
     }
-    
+
     // 返回缓存当前大小
-    size_t size() {
-        return t1.size() + t2.size();
+    size_t size() const {
+        return sizes[T1] + sizes[T2];
     }
-    
+
+    Stats stats() const {
+        Stats st;
+        st.hits = hits;
+        st.misses = misses;
+        st.b1GhostHits = b1GhostHits;
+        st.b2GhostHits = b2GhostHits;
+        st.p = p;
+        st.t1 = sizes[T1]; st.t2 = sizes[T2]; st.b1 = sizes[B1]; st.b2 = sizes[B2];
+        return st;
+    }
+
     // 显示当前状态信息
     void printStatus() {
-        std::cout << "ARC Status:" << std::endl;
+        std::cout << "CAR Status:" << std::endl;
         std::cout << "p = " << p << std::endl;
-        std::cout << "T1 size: " << t1.size() << ", T2 size: " << t2.size() << std::endl;
-        std::cout << "B1 size: " << b1.size() << ", B2 size: " << b2.size() << std::endl;
+        std::cout << "T1 size: " << sizes[T1] << ", T2 size: " << sizes[T2] << std::endl;
+        std::cout << "B1 size: " << sizes[B1] << ", B2 size: " << sizes[B2] << std::endl;
     }
 };
 
+#ifndef NO_MAIN
+// 吞吐测试：80% 请求落在 capacity/2 个热点键上，其余均匀分布在 10*capacity 个键上，
+// 未命中时 put，统计 ops/s 与命中率
+void benchmarkARC(size_t capacity, size_t ops) {
+    ARCache<uint64_t, uint64_t> cache(capacity);
+    std::mt19937_64 rng(2024);
+    std::vector<uint64_t> keys(ops);
+    for (auto& k : keys) {
+        k = (rng() % 10 < 8) ? rng() % (capacity / 2) : capacity + rng() % (10 * capacity);
+    }
+
+    size_t hits = 0;
+    uint64_t value;
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t k : keys) {
+        if (cache.get(k, value)) {
+            hits++;
+        } else {
+            cache.put(k, k);
+        }
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "capacity=" << capacity << " ops=" << ops
+              << " ops/s=" << static_cast<uint64_t>(ops / secs)
+              << " hit ratio=" << static_cast<double>(hits) / ops << std::endl;
+}
+
+// TTL 的开销与清理：同一访问序列分别不带 TTL、带足够长的 TTL（只有记账，不会过期）回放；
+// 再写入 capacity 个 200ms 过期的条目，过期后写入不带 TTL 的新 key，看 put 顺带清理的速度，
+// 缓存留有富余，新 key 不会挤掉旧条目；最后对比一次性 removeExpired 的耗时
+void benchmarkTTL(size_t capacity, size_t ops) {
+    std::mt19937_64 rng(2024);
+    std::vector<uint64_t> keys(ops);
+    for (auto& k : keys) {
+        k = (rng() % 10 < 8) ? rng() % (capacity / 2) : capacity + rng() % (10 * capacity);
+    }
+    for (bool ttl : {false, true}) {
+        ARCache<uint64_t, uint64_t> cache(capacity);
+        size_t hits = 0;
+        uint64_t value;
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t k : keys) {
+            if (cache.get(k, value)) {
+                hits++;
+            } else if (ttl) {
+                cache.put(k, k, std::chrono::hours(1));
+            } else {
+                cache.put(k, k);
+            }
+        }
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << (ttl ? "ttl=1h  " : "no ttl  ") << " ops/s=" << static_cast<uint64_t>(ops / secs)
+                  << " hit ratio=" << static_cast<double>(hits) / ops << std::endl;
+    }
+
+    ARCache<uint64_t, uint64_t> cache(2 * capacity);
+    for (uint64_t k = 0; k < capacity; k++) cache.put(k, k, std::chrono::milliseconds(200));
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    uint64_t puts = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (cache.stats().expired < capacity) {
+        cache.put(capacity + puts, puts);
+        puts++;
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "expired " << cache.stats().expired << " entries during " << puts
+              << " puts (" << secs * 1000 << " ms), size=" << cache.size() << std::endl;
+
+    for (uint64_t k = 0; k < capacity; k++) cache.put(k, k, std::chrono::milliseconds(200));
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    start = std::chrono::steady_clock::now();
+    size_t removed = cache.removeExpired();
+    secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "removeExpired: " << removed << " entries in " << secs * 1000 << " ms" << std::endl;
+}
+
+// 快照：capacity 个驻留条目（一半在 T2）加上一部分历史记录，写出后读进一个新缓存；
+// 对照是重启后按原来的顺序重新 put 一遍同样的 key（不计后端加载的耗时）。
+// 冷读前用 posix_fadvise 把文件逐出页缓存，读的是磁盘
+void benchmarkSnapshot(size_t capacity, const std::string& path) {
+    uint64_t p;
+    {
+        ARCache<uint64_t, uint64_t> cache(capacity);
+        for (uint64_t k = 0; k < capacity; k++) cache.put(k, k);
+        uint64_t value;
+        for (uint64_t k = 0; k < capacity; k += 2) cache.get(k, value);
+        for (uint64_t k = capacity; k < capacity + capacity / 5; k++) cache.put(k, k);
+        p = cache.stats().p;
+
+        auto start = std::chrono::steady_clock::now();
+        cache.saveSnapshot(path);
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        auto st = cache.stats();
+        std::cout << "save: T1=" << st.t1 << " T2=" << st.t2 << " B1=" << st.b1 << " B2=" << st.b2
+                  << " in " << secs * 1000 << " ms" << std::endl;
+    }
+
+    for (bool cold : {false, true}) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        struct stat st;
+        ::fstat(fd, &st);
+        if (cold) {
+            ::fdatasync(fd);
+            ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        }
+        ::close(fd);
+        ARCache<uint64_t, uint64_t> cache(capacity);
+        auto start = std::chrono::steady_clock::now();
+        cache.loadSnapshot(path);
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "load (" << (cold ? "cold page cache" : "warm page cache") << "): "
+                  << st.st_size / (1 << 20) << " MB, " << cache.size() << " entries in " << secs * 1000
+                  << " ms, p " << (cache.stats().p == p ? "restored" : "differs") << std::endl;
+    }
+
+    {
+        ARCache<uint64_t, uint64_t> cache(capacity);
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t k = 0; k < capacity; k++) cache.put(k, k);
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "refill by put: " << capacity << " entries in " << secs * 1000 << " ms (no policy state)"
+                  << std::endl;
+    }
+    std::remove(path.c_str());
+}
+
+// 并发吞吐测试：threads 个线程各自按相同分布访问，统计总 ops/s
+template <typename Cache>
+double benchmarkConcurrent(Cache& cache, size_t capacity, int threads, size_t opsPerThread) {
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            std::mt19937_64 rng(t + 1);
+            uint64_t value;
+            for (size_t i = 0; i < opsPerThread; i++) {
+                uint64_t k = (rng() % 10 < 8) ? rng() % (capacity / 2) : capacity + rng() % (10 * capacity);
+                if (!cache.get(k, value)) cache.put(k, k);
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return threads * opsPerThread / secs;
+}
+
+void benchmarkSharded(size_t capacity, size_t opsPerThread) {
+    std::cout << "threads  global-lock  64-shards  64-shards+buffered-reads (ops/s)" << std::endl;
+    for (int threads : {1, 2, 4, 8, 16, 32}) {
+        ShardedARCache<uint64_t, uint64_t> global(capacity, 1);
+        ShardedARCache<uint64_t, uint64_t> sharded(capacity, 64);
+        ShardedARCache<uint64_t, uint64_t> buffered(capacity, 64, true);
+        double a = benchmarkConcurrent(global, capacity, threads, opsPerThread);
+        double b = benchmarkConcurrent(sharded, capacity, threads, opsPerThread);
+        double c = benchmarkConcurrent(buffered, capacity, threads, opsPerThread);
+        std::cout << threads << "  " << static_cast<uint64_t>(a) << "  " << static_cast<uint64_t>(b)
+                  << "  " << static_cast<uint64_t>(c) << std::endl;
+    }
+
+    ShardedARCache<uint64_t, uint64_t> buffered(capacity, 64, true);
+    benchmarkConcurrent(buffered, capacity, 8, opsPerThread);
+    buffered.flushReadBuffers();
+    auto st = buffered.stats();
+    std::cout << "buffered stats: hits=" << st.hits << " misses=" << st.misses
+              << " hit ratio=" << static_cast<double>(st.hits) / (st.hits + st.misses)
+              << " T1=" << st.t1 << " T2=" << st.t2 << " B1=" << st.b1 << " B2=" << st.b2 << std::endl;
+}
+
+// 按 Zipf(alpha) 分布生成 [0, n) 的访问序列，用预计算的累积分布二分采样
+std::vector<uint32_t> zipfTrace(size_t n, double alpha, size_t length, uint64_t seed) {
+    std::vector<double> cdf(n);
+    double sum = 0;
+    for (size_t i = 0; i < n; i++) {
+        sum += 1.0 / std::pow(static_cast<double>(i + 1), alpha);
+        cdf[i] = sum;
+    }
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> dist(0, sum);
+    std::vector<uint32_t> trace(length);
+    for (auto& t : trace) {
+        t = static_cast<uint32_t>(std::lower_bound(cdf.begin(), cdf.end(), dist(rng)) - cdf.begin());
+    }
+    // 打乱编号，避免热点 key 恰好是连续整数
+    std::vector<uint32_t> perm(n);
+    for (size_t i = 0; i < n; i++) perm[i] = static_cast<uint32_t>(i);
+    std::shuffle(perm.begin(), perm.end(), rng);
+    for (auto& t : trace) t = perm[t];
+    return trace;
+}
+
+// 在同一条 trace 上回放，比较完整 key 幽灵列表与指纹幽灵列表的堆内存和命中率
+template <typename GhostFingerprint>
+void replayGhostMode(const char* name, const std::vector<std::string>& keys,
+                     const std::vector<uint32_t>& trace, size_t capacity) {
+    size_t before = mallinfo2().uordblks;
+    size_t hits = 0;
+    {
+        ARCache<std::string, uint64_t, std::hash<std::string>, std::equal_to<std::string>, GhostFingerprint>
+            cache(capacity);
+        uint64_t value;
+        for (uint32_t idx : trace) {
+            if (cache.get(keys[idx], value)) {
+                hits++;
+            } else {
+                cache.put(keys[idx], idx);
+            }
+        }
+        size_t bytes = mallinfo2().uordblks - before;
+        auto st = cache.stats();
+        size_t tracked = st.t1 + st.t2 + st.b1 + st.b2;
+        std::cout << name << ": heap=" << bytes / 1024 << "KB"
+                  << " tracked=" << tracked << " (ghosts " << st.b1 + st.b2 << ")"
+                  << " bytes/tracked=" << bytes / tracked
+                  << " hit ratio=" << static_cast<double>(hits) / trace.size() << std::endl;
+    }
+}
+
+void benchmarkGhostModes() {
+    const size_t universe = 1000000, capacity = 100000;
+    std::vector<std::string> keys(universe);
+    for (size_t i = 0; i < universe; i++) {
+        // 模拟较长的业务 key（约 64 字节）
+        std::string k = "tenant-42/session/" + std::to_string(i) + "/";
+        k.resize(64, 'x');
+        keys[i] = k;
+    }
+    for (double alpha : {0.8, 1.0}) {
+        std::vector<uint32_t> trace = zipfTrace(universe, alpha, 5000000, 7);
+        std::cout << "zipf alpha=" << alpha << ", capacity=" << capacity << ", 64B string keys" << std::endl;
+        replayGhostMode<void>("  full-key ghosts ", keys, trace, capacity);
+        replayGhostMode<uint64_t>("  64-bit fp ghosts", keys, trace, capacity);
+        replayGhostMode<uint32_t>("  32-bit fp ghosts", keys, trace, capacity);
+    }
+}
+
+// 按字节预算缓存大小不一的对象：条目数容量 vs 字节容量 vs 字节容量 + 准入上限
+void replaySized(const char* name, const std::vector<uint32_t>& trace, const std::vector<size_t>& sizes,
+                 size_t capacity, ARCache<uint32_t, std::string>::Weigher weigher, size_t maxEntryWeight) {
+    size_t before = mallinfo2().uordblks;
+    uint64_t hits = 0, hitBytes = 0, totalBytes = 0;
+    {
+        ARCache<uint32_t, std::string> cache(capacity, weigher, maxEntryWeight);
+        std::string value;
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t k : trace) {
+            totalBytes += sizes[k];
+            if (cache.get(k, value)) {
+                hits++;
+                hitBytes += sizes[k];
+            } else {
+                cache.put(k, std::string(sizes[k], 'v'));
+            }
+        }
+        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                      std::chrono::steady_clock::now() - start).count();
+        size_t bytes = mallinfo2().uordblks - before;
+        auto st = cache.stats();
+        std::cout << name << ": heap " << bytes / (1 << 20) << " MB, entries " << cache.size()
+                  << ", hit ratio " << 100.0 * hits / trace.size() << "%, byte hit ratio "
+                  << 100.0 * hitBytes / totalBytes << "%, rejected " << st.rejected
+                  << ", " << ms << " ms" << std::endl;
+    }
+}
+
+void benchmarkSizeAware() {
+    const size_t universe = 20000, budget = 256u << 20;
+    // 对象大小在 100B ~ 1MB 之间按对数均匀分布，与热度无关
+    std::mt19937_64 rng(11);
+    std::uniform_real_distribution<double> logSize(std::log(100.0), std::log(1048576.0));
+    std::vector<size_t> sizes(universe);
+    double mean = 0;
+    for (auto& sz : sizes) {
+        sz = static_cast<size_t>(std::exp(logSize(rng)));
+        mean += sz;
+    }
+    mean /= universe;
+    std::vector<uint32_t> trace = zipfTrace(universe, 0.9, 200000, 13);
+    auto bytes = [](const uint32_t&, const std::string& v) { return v.size() + sizeof(uint32_t); };
+    size_t countCapacity = static_cast<size_t>(budget / mean);
+    std::cout << "size-aware ARC, budget " << (budget >> 20) << " MB, mean object "
+              << static_cast<size_t>(mean) << " B, zipf 0.9" << std::endl;
+    replaySized("  count capacity   ", trace, sizes, countCapacity, nullptr, 0);
+    replaySized("  byte budget      ", trace, sizes, budget, bytes, 0);
+    replaySized("  byte budget+256KB", trace, sizes, budget, bytes, 256u << 10);
+}
+
+// 在同一条 trace 上回放，比较 ARC 与 CAR 的命中率和单线程吞吐
+template <typename Cache>
+void replayPolicy(const char* name, const std::vector<uint32_t>& trace, size_t capacity) {
+    Cache cache(capacity);
+    size_t hits = 0;
+    uint64_t value;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t k : trace) {
+        if (cache.get(k, value)) {
+            hits++;
+        } else {
+            cache.put(k, k);
+        }
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << name << ": hit ratio=" << static_cast<double>(hits) / trace.size()
+              << " ops/s=" << static_cast<uint64_t>(trace.size() / secs) << std::endl;
+}
+
+void benchmarkCAR() {
+    const size_t universe = 1000000, capacity = 100000, length = 5000000;
+    std::vector<std::pair<std::string, std::vector<uint32_t>>> traces;
+    traces.emplace_back("zipf 0.8", zipfTrace(universe, 0.8, length, 7));
+    traces.emplace_back("zipf 1.0", zipfTrace(universe, 1.0, length, 7));
+    // zipf 0.9 中每 50 万次请求插入一段 20 万个从未出现过的 key 的顺序扫描
+    std::vector<uint32_t> scan = zipfTrace(universe, 0.9, length, 7);
+    uint32_t fresh = static_cast<uint32_t>(universe);
+    for (size_t i = 0; i + 200000 <= scan.size(); i += 500000) {
+        for (size_t j = 0; j < 200000; j++) scan[i + j] = fresh++;
+    }
+    traces.emplace_back("zipf 0.9 + scans", std::move(scan));
+    for (auto& [name, trace] : traces) {
+        std::cout << name << ", capacity=" << capacity << std::endl;
+        replayPolicy<ARCache<uint64_t, uint64_t>>("  ARC", trace, capacity);
+        replayPolicy<CARCache<uint64_t, uint64_t>>("  CAR", trace, capacity);
+    }
+
+    // 并发读：ARC 的 get 要改链表，只能拿互斥锁；CAR 命中只置位引用位，get 拿共享锁
+    struct LockedARC {
+        std::mutex mtx;
+        ARCache<uint64_t, uint64_t> cache;
+        explicit LockedARC(size_t c) : cache(c) {}
+        bool get(uint64_t k, uint64_t& v) {
+            std::lock_guard<std::mutex> lock(mtx);
+            return cache.get(k, v);
+        }
+        void put(uint64_t k, uint64_t v) {
+            std::lock_guard<std::mutex> lock(mtx);
+            cache.put(k, v);
+        }
+    };
+    struct SharedCAR {
+        std::shared_mutex mtx;
+        CARCache<uint64_t, uint64_t> cache;
+        explicit SharedCAR(size_t c) : cache(c) {}
+        bool get(uint64_t k, uint64_t& v) {
+            std::shared_lock<std::shared_mutex> lock(mtx);
+            return cache.sharedGet(k, v);
+        }
+        void put(uint64_t k, uint64_t v) {
+            std::unique_lock<std::shared_mutex> lock(mtx);
+            cache.put(k, v);
+        }
+    };
+    std::cout << "threads  ARC+mutex  CAR+shared_mutex (ops/s)" << std::endl;
+    for (int threads : {1, 2, 4, 8}) {
+        LockedARC arc(capacity);
+        SharedCAR car(capacity);
+        double a = benchmarkConcurrent(arc, capacity, threads, 500000);
+        double c = benchmarkConcurrent(car, capacity, threads, 500000);
+        std::cout << threads << "  " << static_cast<uint64_t>(a) << "  " << static_cast<uint64_t>(c) << std::endl;
+    }
+}
+
 // 使用示例
-int main() {
+// 带参数 bench 时运行性能测试
+int main(int argc, char** argv) {
+    if (argc > 1 && std::string(argv[1]) == "bench") {
+        benchmarkARC(1000000, 10000000);
+        benchmarkSharded(1000000, 500000);
+        benchmarkGhostModes();
+        benchmarkSizeAware();
+        benchmarkCAR();
+        benchmarkTTL(1000000, 10000000);
+        benchmarkSnapshot(10000000, "/tmp/arc.snapshot");  // 测完删除快照文件
+        return 0;
+    }
+
     ARCache<int, std::string> cache(4);
-    
+
     cache.put(1, "one");
     cache.put(2, "two");
     cache.put(3, "three");
     cache.put(4, "four");
-    
+
     cache.printStatus();
-    
+
     std::cout << "Get 1: " << cache.get(1) << std::endl;
     std::cout << "Get 2: " << cache.get(2) << std::endl;
-    
+
     cache.put(5, "five");  // 会触发替换
-    
+
     cache.printStatus();
-    
+
     std::cout << "Contains 3: " << (cache.contains(3) ? "Yes" : "No") << std::endl;
     std::cout << "Contains 5: " << (cache.contains(5) ? "Yes" : "No") << std::endl;
-    
+
+    cache.put(6, "six", std::chrono::milliseconds(50));
+    std::cout << "Contains 6: " << (cache.contains(6) ? "Yes" : "No");
+    std::this_thread::sleep_for(std::chrono::milliseconds(80));
+    std::cout << ", after 80ms: " << (cache.contains(6) ? "Yes" : "No") << std::endl;
+
     return 0;
-}
\ No newline at end of file
+}
+#endif
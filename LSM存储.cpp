@@ -0,0 +1,853 @@
+// 以 SkipList 作为 memtable 的小型 LSM 存储：
+//   写入：追加 WAL（组提交 fdatasync）-> 落盘后按序号写入 memtable，读不到尚未持久化的数据
+//   memtable 超过阈值后冻结为 immutable，后台线程流式落盘为带块索引的有序文件(SST)
+//   读取：active memtable -> immutable（新到旧）-> SST（新到旧），墓碑表示删除
+#define NO_MAIN
+#include "跳表.cpp"
+#undef NO_MAIN
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+// memtable / SST 中的一条记录，tombstone 为 true 表示删除标记
+struct MemEntry {
+    bool tombstone = false;
+    std::string value;
+};
+
+enum RecordType : uint8_t { kPut = 1, kDelete = 2 };
+
+// ---------------- 编码工具 ----------------
+static void putU32(std::string& dst, uint32_t v) { dst.append(reinterpret_cast<const char*>(&v), 4); }
+static void putU64(std::string& dst, uint64_t v) { dst.append(reinterpret_cast<const char*>(&v), 8); }
+static uint32_t getU32(const char* p) { uint32_t v; std::memcpy(&v, p, 4); return v; }
+static uint64_t getU64(const char* p) { uint64_t v; std::memcpy(&v, p, 8); return v; }
+
+// FNV-1a，用于检测 WAL 尾部的半条记录
+static uint32_t checksum(const char* data, size_t n) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < n; i++) {
+        h ^= static_cast<uint8_t>(data[i]);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static void writeAll(int fd, const char* data, size_t n) {
+    while (n > 0) {
+        ssize_t w = ::write(fd, data, n);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error("write failed");
+        }
+        data += w;
+        n -= w;
+    }
+}
+
+// 让目录项的变化（新建、rename）持久化
+static void syncDir(const std::string& dir) {
+    int dfd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (dfd < 0) throw std::runtime_error("open dir failed: " + dir);
+    int rc = ::fsync(dfd);
+    ::close(dfd);
+    if (rc != 0) throw std::runtime_error("fsync dir failed: " + dir);
+}
+
+static std::string fileName(const std::string& dir, uint64_t number, const char* suffix) {
+    return dir + "/" + std::to_string(number) + suffix;
+}
+
+// ---------------- 预写日志 ----------------
+// 记录格式：[u32 checksum][u8 type][u32 klen][u32 vlen][key][value]
+class WriteAheadLog {
+public:
+    struct PendingWrite {
+        RecordType type;
+        std::string key;
+        std::string value;
+    };
+    // 一批记录写盘成功后按序号顺序调用，由它把记录写入 memtable
+    using Publish = std::function<void(const std::vector<PendingWrite>&)>;
+
+private:
+    int fd;
+    bool sync;
+    Publish publish;
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::string buffer;                 // 已追加但尚未写入文件的记录
+    std::vector<PendingWrite> pending;  // 与 buffer 对应，写盘成功后交给 publish
+    uint64_t appendedSeq = 0;    // 已追加的记录序号
+    uint64_t committedSeq = 0;   // 已写入(并同步)的记录序号
+    bool committing = false;     // 是否有 leader 正在写盘
+    uint64_t groups = 0;         // 写盘批次数
+    // 写盘失败后文件尾部的状态未知，之后追加的记录即使写进去重放时也读不到，
+    // 所以错误一直保留：序号大于 committedSeq 的提交全部失败
+    std::exception_ptr error;
+
+public:
+    uint64_t number;
+
+    WriteAheadLog(const std::string& path, uint64_t num, bool syncWrites, Publish onCommit)
+        : sync(syncWrites), publish(std::move(onCommit)), number(num) {
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (fd < 0) throw std::runtime_error("open wal failed: " + path);
+    }
+
+    // 每条追加的记录都由写入线程提交过，缓冲区此时为空
+    ~WriteAheadLog() {
+        ::close(fd);
+    }
+
+    static std::string encode(RecordType type, const std::string& key, const std::string& value) {
+        std::string rec;
+        putU32(rec, 0);
+        rec.push_back(static_cast<char>(type));
+        putU32(rec, key.size());
+        putU32(rec, value.size());
+        rec += key;
+        rec += value;
+        uint32_t crc = checksum(rec.data() + 4, rec.size() - 4);
+        std::memcpy(&rec[0], &crc, 4);
+        return rec;
+    }
+
+    uint64_t append(RecordType type, const std::string& key, const std::string& value) {
+        std::string record = encode(type, key, value);
+        std::lock_guard<std::mutex> lock(mtx);
+        if (error) std::rethrow_exception(error);
+        buffer += record;
+        pending.push_back({type, key, value});
+        return ++appendedSeq;
+    }
+
+    uint64_t lastSeq() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return appendedSeq;
+    }
+
+    // 组提交：第一个到达的线程成为 leader，把当前缓冲区里所有线程的记录
+    // 一次 write + fdatasync，成功后按序号顺序 publish，其余线程等待自己的序号被覆盖。
+    // 写盘、同步或 publish 失败时记下错误并唤醒所有等待者，序号未被覆盖的线程各自抛出这个错误
+    void commit(uint64_t seq) {
+        std::unique_lock<std::mutex> lock(mtx);
+        while (committedSeq < seq) {
+            if (error) std::rethrow_exception(error);
+            if (committing) {
+                cv.wait(lock);
+                continue;
+            }
+            committing = true;
+            std::string batch;
+            batch.swap(buffer);
+            std::vector<PendingWrite> writes;
+            writes.swap(pending);
+            uint64_t target = appendedSeq;
+            lock.unlock();
+
+            std::exception_ptr failure;
+            try {
+                writeAll(fd, batch.data(), batch.size());
+                if (sync && ::fdatasync(fd) != 0) throw std::runtime_error("wal fdatasync failed");
+                publish(writes);
+            } catch (...) {
+                failure = std::current_exception();
+            }
+
+            lock.lock();
+            committing = false;
+            if (failure) {
+                error = failure;
+            } else {
+                committedSeq = target;
+                groups++;
+            }
+            cv.notify_all();
+        }
+    }
+
+    uint64_t groupCount() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return groups;
+    }
+
+    // 重放日志，遇到不完整或校验失败的记录即停止（崩溃时写了一半的尾部）
+    template<typename F>
+    static void replay(const std::string& path, F&& apply) {
+        int rfd = ::open(path.c_str(), O_RDONLY);
+        if (rfd < 0) return;
+        std::string data;
+        char buf[1 << 16];
+        ssize_t n;
+        while ((n = ::read(rfd, buf, sizeof(buf))) > 0) data.append(buf, n);
+        ::close(rfd);
+
+        size_t pos = 0;
+        while (pos + 13 <= data.size()) {
+            const char* p = data.data() + pos;
+            uint32_t klen = getU32(p + 5), vlen = getU32(p + 9);
+            if (pos + 13 + klen + vlen > data.size()) break;
+            if (checksum(p + 4, 9 + klen + vlen) != getU32(p)) break;
+            apply(static_cast<RecordType>(p[4]), std::string(p + 13, klen), std::string(p + 13 + klen, vlen));
+            pos += 13 + klen + vlen;
+        }
+    }
+};
+
+// ---------------- memtable ----------------
+class MemTable {
+private:
+    SkipList<std::string, MemEntry> table{16, 0.25};
+    size_t bytes = 0;
+
+public:
+    std::vector<uint64_t> walNumbers;  // 数据还只存在于这些 WAL 中，落盘后才能删除
+
+    void apply(RecordType type, const std::string& key, const std::string& value) {
+        MemEntry e{type == kDelete, type == kDelete ? std::string() : value};
+        // 节点本身加上平均约两层 forward 指针的开销
+        bytes += key.size() + e.value.size() + sizeof(void*) * 2 + 64;
+        table.insert(key, std::move(e));
+    }
+
+    // 命中（含墓碑）返回 true
+    bool get(const std::string& key, MemEntry& e) const {
+        return table.search(key, e);
+    }
+
+    size_t approximateBytes() const { return bytes; }
+    size_t size() const { return table.size(); }
+
+    SkipList<std::string, MemEntry>::Iterator begin() const { return table.begin(); }
+    SkipList<std::string, MemEntry>::Iterator lowerBound(const std::string& key) const {
+        return table.lowerBound(key);
+    }
+};
+
+// ---------------- SST 文件 ----------------
+// 数据块：连续的 [u8 type][u32 klen][u32 vlen][key][value]
+// 索引块：每个数据块一项 [u32 klen][lastKey][u64 offset][u32 size]
+// 尾部：  [u64 indexOffset][u32 indexSize][u32 entryCount][u64 magic]
+static const uint64_t kTableMagic = 0x4c534d5353544142ull;
+static const size_t kFooterSize = 24;
+
+class SSTableWriter {
+private:
+    int fd;
+    size_t blockSize;
+    uint64_t offset = 0;
+    uint32_t count = 0;
+    std::string block;
+    std::string index;
+    std::string lastKey;
+
+    void flushBlock() {
+        if (block.empty()) return;
+        writeAll(fd, block.data(), block.size());
+        putU32(index, lastKey.size());
+        index += lastKey;
+        putU64(index, offset);
+        putU32(index, block.size());
+        offset += block.size();
+        block.clear();
+    }
+
+public:
+    SSTableWriter(const std::string& path, size_t blkSize) : blockSize(blkSize) {
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) throw std::runtime_error("open sst failed: " + path);
+    }
+
+    ~SSTableWriter() {
+        if (fd >= 0) ::close(fd);
+    }
+
+    // key 必须严格递增
+    void add(const std::string& key, const MemEntry& e) {
+        block.push_back(static_cast<char>(e.tombstone ? kDelete : kPut));
+        putU32(block, key.size());
+        putU32(block, e.value.size());
+        block += key;
+        block += e.value;
+        lastKey = key;
+        count++;
+        if (block.size() >= blockSize) flushBlock();
+    }
+
+    void finish() {
+        flushBlock();
+        std::string footer;
+        putU64(footer, offset);
+        putU32(footer, index.size());
+        putU32(footer, count);
+        putU64(footer, kTableMagic);
+        writeAll(fd, index.data(), index.size());
+        writeAll(fd, footer.data(), footer.size());
+        if (::fdatasync(fd) != 0) throw std::runtime_error("sst fdatasync failed");
+        int rc = ::close(fd);
+        fd = -1;
+        if (rc != 0) throw std::runtime_error("sst close failed");
+    }
+};
+
+class SSTable {
+private:
+    struct IndexEntry {
+        std::string lastKey;
+        uint64_t offset;
+        uint32_t size;
+    };
+
+    int fd = -1;
+    std::vector<IndexEntry> index;
+
+    std::string readBlock(size_t i) const {
+        std::string buf(index[i].size, '\0');
+        ssize_t n = ::pread(fd, &buf[0], buf.size(), index[i].offset);
+        if (n != static_cast<ssize_t>(buf.size())) throw std::runtime_error("short read");
+        return buf;
+    }
+
+    // 第一个 lastKey >= key 的块
+    size_t findBlock(const std::string& key) const {
+        size_t lo = 0, hi = index.size();
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (index[mid].lastKey < key) lo = mid + 1;
+            else hi = mid;
+        }
+        return lo;
+    }
+
+    static void decodeBlock(const std::string& block,
+                            std::vector<std::pair<std::string, MemEntry>>& out) {
+        out.clear();
+        size_t pos = 0;
+        while (pos + 9 <= block.size()) {
+            const char* p = block.data() + pos;
+            uint32_t klen = getU32(p + 1), vlen = getU32(p + 5);
+            if (pos + 9 + klen + vlen > block.size()) throw std::runtime_error("corrupted sst block");
+            out.push_back({std::string(p + 9, klen),
+                           MemEntry{p[0] == kDelete, std::string(p + 9 + klen, vlen)}});
+            pos += 9 + klen + vlen;
+        }
+    }
+
+public:
+    uint64_t number;
+    uint32_t entryCount = 0;
+
+    SSTable(const std::string& path, uint64_t num) : number(num) {
+        fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("open sst failed: " + path);
+        off_t fileSize = ::lseek(fd, 0, SEEK_END);
+        char footer[kFooterSize];
+        if (fileSize < static_cast<off_t>(kFooterSize) ||
+            ::pread(fd, footer, kFooterSize, fileSize - kFooterSize) != static_cast<ssize_t>(kFooterSize) ||
+            getU64(footer + 16) != kTableMagic) {
+            ::close(fd);
+            throw std::runtime_error("corrupted sst: " + path);
+        }
+        uint64_t indexOffset = getU64(footer);
+        uint32_t indexSize = getU32(footer + 8);
+        entryCount = getU32(footer + 12);
+        uint64_t dataEnd = static_cast<uint64_t>(fileSize) - kFooterSize;
+        auto corrupt = [&]() {
+            ::close(fd);
+            fd = -1;
+            throw std::runtime_error("corrupted sst: " + path);
+        };
+        if (indexOffset > dataEnd || indexSize > dataEnd - indexOffset) corrupt();
+
+        std::string buf(indexSize, '\0');
+        if (::pread(fd, &buf[0], indexSize, indexOffset) != static_cast<ssize_t>(indexSize)) corrupt();
+        // 每一项都先检查长度和指向的块是否落在数据区内，截断或损坏的文件不会越界读
+        size_t pos = 0;
+        while (pos < buf.size()) {
+            if (buf.size() - pos < 16) corrupt();
+            uint32_t klen = getU32(buf.data() + pos);
+            if (klen > buf.size() - pos - 16) corrupt();
+            IndexEntry e;
+            e.lastKey.assign(buf.data() + pos + 4, klen);
+            e.offset = getU64(buf.data() + pos + 4 + klen);
+            e.size = getU32(buf.data() + pos + 12 + klen);
+            if (e.offset > indexOffset || e.size > indexOffset - e.offset) corrupt();
+            index.push_back(std::move(e));
+            pos += 16 + klen;
+        }
+    }
+
+    ~SSTable() {
+        if (fd >= 0) ::close(fd);
+    }
+
+    SSTable(const SSTable&) = delete;
+    SSTable& operator=(const SSTable&) = delete;
+
+    // 只读一个块：索引二分定位，块内顺序扫描
+    bool get(const std::string& key, MemEntry& e) const {
+        size_t b = findBlock(key);
+        if (b == index.size()) return false;
+        std::string block = readBlock(b);
+        size_t pos = 0;
+        while (pos + 9 <= block.size()) {
+            const char* p = block.data() + pos;
+            uint32_t klen = getU32(p + 1), vlen = getU32(p + 5);
+            if (pos + 9 + klen + vlen > block.size()) throw std::runtime_error("corrupted sst block");
+            int cmp = key.compare(0, std::string::npos, p + 9, klen);
+            if (cmp == 0) {
+                e.tombstone = p[0] == kDelete;
+                e.value.assign(p + 9 + klen, vlen);
+                return true;
+            }
+            if (cmp < 0) return false;
+            pos += 9 + klen + vlen;
+        }
+        return false;
+    }
+
+    // 按块流式读取的游标，只缓存当前块
+    class Cursor {
+    private:
+        const SSTable* table;
+        size_t blockIdx;
+        size_t pos = 0;
+        std::vector<std::pair<std::string, MemEntry>> entries;
+
+        void load() {
+            pos = 0;
+            entries.clear();
+            while (blockIdx < table->index.size() && entries.empty()) {
+                decodeBlock(table->readBlock(blockIdx), entries);
+                if (entries.empty()) blockIdx++;
+            }
+        }
+
+    public:
+        Cursor(const SSTable* t, const std::string& start) : table(t), blockIdx(t->findBlock(start)) {
+            load();
+            while (valid() && key() < start) next();
+        }
+        bool valid() const { return pos < entries.size(); }
+        const std::string& key() const { return entries[pos].first; }
+        const MemEntry& entry() const { return entries[pos].second; }
+        void next() {
+            if (++pos == entries.size()) {
+                blockIdx++;
+                load();
+            }
+        }
+    };
+};
+
+// ---------------- 存储引擎 ----------------
+struct LSMOptions {
+    std::string dir;
+    size_t memtableBytes = 4 << 20;  // memtable 冻结阈值
+    size_t blockSize = 4096;         // SST 数据块大小
+    size_t maxImmutables = 2;        // 待落盘的 immutable 超过该数量时写入阻塞
+    bool syncWrites = true;          // 每次写入返回前 fdatasync（组提交）
+};
+
+class LSMStore {
+private:
+    LSMOptions opts;
+    std::mutex mtx;
+    std::condition_variable flushCv;      // 通知后台线程有 immutable 待落盘
+    std::condition_variable flushDoneCv;  // 通知写入线程落盘完成
+    std::shared_ptr<MemTable> mem;
+    std::shared_ptr<WriteAheadLog> wal;
+    std::deque<std::shared_ptr<MemTable>> imm;           // 由旧到新
+    std::vector<std::shared_ptr<SSTable>> tables;        // 由旧到新
+    uint64_t nextFileNumber = 1;
+    uint64_t stallCount = 0;
+    bool freezing = false;  // 正在等待 active memtable 的 WAL 提交完，期间不接受新写入
+    bool stopping = false;
+    // 落盘失败（磁盘满、I/O 错误）后保留的错误：immutable 和它的 WAL 都留着，之后的写入和 flush 都抛出它
+    std::exception_ptr flushError;
+    std::thread flushThread;
+
+    void recover() {
+        fs::create_directories(opts.dir);
+        std::vector<uint64_t> walNums, sstNums;
+        for (auto& f : fs::directory_iterator(opts.dir)) {
+            std::string name = f.path().filename().string();
+            auto dot = name.find('.');
+            if (dot == std::string::npos || dot == 0 || dot > 19) continue;
+            std::string ext = name.substr(dot);
+            // 目录里可能有别的文件（notes.txt、.nfs123 之类），只认数字编号加已知后缀的文件名
+            if (ext != ".log" && ext != ".sst" && ext != ".sst.tmp") continue;
+            if (!std::all_of(name.begin(), name.begin() + dot, [](char c) { return c >= '0' && c <= '9'; })) continue;
+            uint64_t num = std::stoull(name.substr(0, dot));
+            nextFileNumber = std::max(nextFileNumber, num + 1);
+            if (ext == ".log") walNums.push_back(num);
+            else if (ext == ".sst") sstNums.push_back(num);
+            else if (ext == ".sst.tmp") fs::remove(f.path());  // 落盘中途崩溃留下的残文件
+        }
+        std::sort(walNums.begin(), walNums.end());
+        std::sort(sstNums.begin(), sstNums.end());
+
+        for (uint64_t n : sstNums) {
+            tables.push_back(std::make_shared<SSTable>(fileName(opts.dir, n, ".sst"), n));
+        }
+        mem = std::make_shared<MemTable>();
+        for (uint64_t n : walNums) {
+            WriteAheadLog::replay(fileName(opts.dir, n, ".log"),
+                [this](RecordType t, const std::string& k, const std::string& v) { mem->apply(t, k, v); });
+            mem->walNumbers.push_back(n);
+        }
+        newWal();
+    }
+
+    // 新 WAL 的记录只写入当前的 memtable；该 memtable 冻结前会等这个 WAL 提交完，之后不会再收到记录
+    void newWal() {
+        uint64_t n = nextFileNumber++;
+        MemTable* target = mem.get();
+        wal = std::make_shared<WriteAheadLog>(fileName(opts.dir, n, ".log"), n, opts.syncWrites,
+            [this, target](const std::vector<WriteAheadLog::PendingWrite>& writes) {
+                std::lock_guard<std::mutex> lock(mtx);
+                for (const auto& w : writes) target->apply(w.type, w.key, w.value);
+            });
+        // 新建的 WAL 文件本身也要在目录里持久化，fdatasync 只保证文件内容
+        if (opts.syncWrites) syncDir(opts.dir);
+        mem->walNumbers.push_back(n);
+    }
+
+    // 冻结 active memtable 并切换 WAL。已追加的记录要先提交完并写入 memtable，
+    // 否则后台线程会无锁遍历一个还在变化的 memtable；这些记录提交失败时不会进入 memtable，
+    // 写入线程各自收到错误，新的 WAL 从干净的文件开始
+    void freezeMemtable(std::unique_lock<std::mutex>& lock) {
+        freezing = true;
+        std::shared_ptr<WriteAheadLog> log = wal;
+        uint64_t last = log->lastSeq();
+        lock.unlock();
+        try {
+            log->commit(last);
+        } catch (const std::exception&) {
+        }
+        lock.lock();
+        freezing = false;
+        imm.push_back(mem);
+        mem = std::make_shared<MemTable>();
+        newWal();
+        flushCv.notify_one();
+        flushDoneCv.notify_all();
+    }
+
+    // memtable 超过阈值时冻结并切换 WAL；immutable 积压过多时阻塞写入
+    void makeRoomForWrite(std::unique_lock<std::mutex>& lock) {
+        while (true) {
+            if (flushError) std::rethrow_exception(flushError);
+            if (!freezing && mem->approximateBytes() < opts.memtableBytes) break;
+            if (freezing) {
+                flushDoneCv.wait(lock);
+                continue;
+            }
+            if (imm.size() >= opts.maxImmutables) {
+                stallCount++;
+                flushDoneCv.wait(lock);
+                continue;
+            }
+            freezeMemtable(lock);
+        }
+    }
+
+    void write(RecordType type, const std::string& key, const std::string& value) {
+        std::shared_ptr<WriteAheadLog> log;
+        uint64_t seq;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            makeRoomForWrite(lock);
+            log = wal;
+            seq = log->append(type, key, value);
+        }
+        // 在存储锁外等待写盘，多个写线程的记录合并为一次 fdatasync；
+        // 写盘成功后由 leader 按序号把整批记录写入 memtable，之后才对读可见
+        log->commit(seq);
+    }
+
+    void backgroundFlush() {
+        std::unique_lock<std::mutex> lock(mtx);
+        while (true) {
+            flushCv.wait(lock, [this] { return stopping || !imm.empty(); });
+            if (imm.empty()) return;
+
+            if (flushError) {
+                // 不再重试，等析构；数据仍在 immutable 和 WAL 里，下次打开时重放
+                flushCv.wait(lock, [this] { return stopping; });
+                return;
+            }
+
+            std::shared_ptr<MemTable> m = imm.front();
+            uint64_t n = nextFileNumber++;
+            lock.unlock();
+
+            // immutable 不再被修改，可以无锁遍历
+            std::string path = fileName(opts.dir, n, ".sst");
+            std::shared_ptr<SSTable> table;
+            try {
+                SSTableWriter writer(path + ".tmp", opts.blockSize);
+                for (auto it = m->begin(); it.valid(); it.next()) {
+                    writer.add(it.key(), it.value());
+                }
+                writer.finish();
+                fs::rename(path + ".tmp", path);
+                // rename 要先持久化，否则崩溃后可能 WAL 已经删掉而 SST 还没出现
+                syncDir(opts.dir);
+                table = std::make_shared<SSTable>(path, n);
+            } catch (...) {
+                std::error_code ec;
+                fs::remove(path + ".tmp", ec);
+                lock.lock();
+                flushError = std::current_exception();
+                flushDoneCv.notify_all();
+                continue;
+            }
+
+            lock.lock();
+            tables.push_back(table);
+            imm.pop_front();
+            for (uint64_t w : m->walNumbers) {
+                fs::remove(fileName(opts.dir, w, ".log"));
+            }
+            flushDoneCv.notify_all();
+        }
+    }
+
+    // 多路归并用的统一游标：sources 按新到旧排列，同 key 取最新的一个
+    struct Source {
+        // memtable 游标
+        SkipList<std::string, MemEntry>::Iterator memIt{nullptr};
+        // SST 游标
+        std::unique_ptr<SSTable::Cursor> sstIt;
+
+        bool valid() const { return sstIt ? sstIt->valid() : memIt.valid(); }
+        const std::string& key() const { return sstIt ? sstIt->key() : memIt.key(); }
+        const MemEntry& entry() const { return sstIt ? sstIt->entry() : memIt.value(); }
+        void next() { if (sstIt) sstIt->next(); else memIt.next(); }
+    };
+
+public:
+    explicit LSMStore(const LSMOptions& options) : opts(options) {
+        recover();
+        flushThread = std::thread([this] { backgroundFlush(); });
+    }
+
+    // 等待已冻结的 memtable 全部落盘；active memtable 留在 WAL 中，下次打开时重放
+    ~LSMStore() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stopping = true;
+        }
+        flushCv.notify_one();
+        flushThread.join();
+    }
+
+    void put(const std::string& key, const std::string& value) { write(kPut, key, value); }
+    void del(const std::string& key) { write(kDelete, key, ""); }
+
+    bool get(const std::string& key, std::string& value) {
+        MemEntry e;
+        std::deque<std::shared_ptr<MemTable>> immSnapshot;
+        std::vector<std::shared_ptr<SSTable>> tableSnapshot;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (mem->get(key, e)) {
+                if (e.tombstone) return false;
+                value = std::move(e.value);
+                return true;
+            }
+            immSnapshot = imm;
+            tableSnapshot = tables;
+        }
+        bool found = false;
+        for (auto it = immSnapshot.rbegin(); it != immSnapshot.rend() && !found; ++it) {
+            found = (*it)->get(key, e);
+        }
+        for (auto it = tableSnapshot.rbegin(); it != tableSnapshot.rend() && !found; ++it) {
+            found = (*it)->get(key, e);
+        }
+        if (!found || e.tombstone) return false;
+        value = std::move(e.value);
+        return true;
+    }
+
+    // 返回 [start, end) 内最多 limit 个有效键值对，end 为空表示不设上界
+    std::vector<std::pair<std::string, std::string>> scan(const std::string& start, const std::string& end,
+                                                         size_t limit = SIZE_MAX) {
+        // active memtable 会被并发修改，在锁内拷贝出所需区间；其余来源只需持有快照
+        auto active = std::make_shared<MemTable>();
+        std::deque<std::shared_ptr<MemTable>> immSnapshot;
+        std::vector<std::shared_ptr<SSTable>> tableSnapshot;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            for (auto it = mem->lowerBound(start); it.valid(); it.next()) {
+                if (!end.empty() && it.key() >= end) break;
+                active->apply(it.value().tombstone ? kDelete : kPut, it.key(), it.value().value);
+            }
+            immSnapshot = imm;
+            tableSnapshot = tables;
+        }
+
+        std::vector<Source> sources;
+        sources.emplace_back();
+        sources.back().memIt = active->begin();
+        for (auto it = immSnapshot.rbegin(); it != immSnapshot.rend(); ++it) {
+            sources.emplace_back();
+            sources.back().memIt = (*it)->lowerBound(start);
+        }
+        for (auto it = tableSnapshot.rbegin(); it != tableSnapshot.rend(); ++it) {
+            sources.emplace_back();
+            sources.back().sstIt = std::make_unique<SSTable::Cursor>(it->get(), start);
+        }
+
+        std::vector<std::pair<std::string, std::string>> result;
+        while (result.size() < limit) {
+            // 来源数量很少，线性找最小 key 即可；同 key 时靠前（更新）的来源胜出
+            Source* best = nullptr;
+            for (auto& s : sources) {
+                if (s.valid() && (best == nullptr || s.key() < best->key())) best = &s;
+            }
+            if (best == nullptr || (!end.empty() && best->key() >= end)) break;
+
+            std::string key = best->key();
+            if (!best->entry().tombstone) result.emplace_back(key, best->entry().value);
+            for (auto& s : sources) {
+                while (s.valid() && s.key() == key) s.next();
+            }
+        }
+        return result;
+    }
+
+    // 冻结当前 memtable 并等待其落盘完成
+    void flush() {
+        std::unique_lock<std::mutex> lock(mtx);
+        while (freezing && !flushError) flushDoneCv.wait(lock);
+        if (!flushError && (mem->size() > 0 || wal->lastSeq() > 0)) {
+            while (!flushError && (freezing || imm.size() >= opts.maxImmutables)) flushDoneCv.wait(lock);
+            if (!flushError) freezeMemtable(lock);
+        }
+        flushDoneCv.wait(lock, [this] { return imm.empty() || flushError; });
+        if (flushError) std::rethrow_exception(flushError);
+    }
+
+    size_t tableCount() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return tables.size();
+    }
+
+    uint64_t stalls() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return stallCount;
+    }
+
+    uint64_t walGroupCount() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return wal->groupCount();
+    }
+};
+
+#ifndef NO_MAIN
+// 写吞吐测试：多个线程并发 put，统计 ops/s 与每次 fdatasync 平均合并的记录数
+void benchmarkWrites(bool syncWrites, int threads, int opsPerThread) {
+    std::string dir = (fs::temp_directory_path() / "lsm_bench").string();
+    fs::remove_all(dir);
+
+    LSMOptions opts;
+    opts.dir = dir;
+    opts.syncWrites = syncWrites;
+    opts.memtableBytes = 64ull << 20;  // 只看 WAL 写入开销，避免中途切换 WAL
+    LSMStore store(opts);
+
+    std::string value(100, 'v');
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            for (int i = 0; i < opsPerThread; i++) {
+                store.put("key-" + std::to_string(t) + "-" + std::to_string(i), value);
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    uint64_t total = static_cast<uint64_t>(threads) * opsPerThread;
+    uint64_t groups = store.walGroupCount();
+    std::cout << "sync=" << syncWrites << " threads=" << threads
+              << " ops/s=" << static_cast<uint64_t>(total / secs)
+              << " records/commit=" << (groups ? static_cast<double>(total) / groups : 0) << std::endl;
+}
+
+// 带参数 bench 时运行写吞吐测试
+int main(int argc, char** argv) {
+    if (argc > 1 && std::string(argv[1]) == "bench") {
+        std::cout << "Write throughput (100B values):" << std::endl;
+        benchmarkWrites(false, 1, 200000);
+        for (int threads : {1, 4, 16}) {
+            benchmarkWrites(true, threads, 2000);
+        }
+        return 0;
+    }
+
+    std::string dir = (fs::temp_directory_path() / "lsm_demo").string();
+    fs::remove_all(dir);
+
+    LSMOptions opts;
+    opts.dir = dir;
+    opts.memtableBytes = 64 << 10;
+    {
+        LSMStore store(opts);
+        for (int i = 0; i < 5000; i++) {
+            char key[16];
+            snprintf(key, sizeof(key), "k%05d", i);
+            store.put(key, "v" + std::to_string(i));
+        }
+        store.del("k00010");
+        store.put("k00020", "updated");
+        store.flush();
+        store.put("k00030", "in-memtable");
+        store.del("k00040");
+
+        std::string value;
+        std::cout << "SST files: " << store.tableCount() << std::endl;
+        std::cout << "k00010 found: " << store.get("k00010", value) << std::endl;
+        if (store.get("k00020", value)) std::cout << "k00020 = " << value << std::endl;
+        if (store.get("k04999", value)) std::cout << "k04999 = " << value << std::endl;
+
+        std::cout << "scan [k00008, k00013):";
+        for (auto& kv : store.scan("k00008", "k00013")) std::cout << " " << kv.first << "=" << kv.second;
+        std::cout << std::endl;
+    }
+
+    // 重新打开：SST 直接加载，未落盘的 memtable 从 WAL 重放
+    {
+        LSMStore store(opts);
+        std::string value;
+        if (store.get("k00030", value)) std::cout << "after reopen k00030 = " << value << std::endl;
+        std::cout << "after reopen k00040 found: " << store.get("k00040", value) << std::endl;
+        std::cout << "after reopen scan count: " << store.scan("", "").size() << std::endl;
+    }
+    return 0;
+}
+#endif
@@ -0,0 +1,530 @@
+#include <bits/stdc++.h>
+#include <malloc.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define NO_MAIN
+#include "ARC.cpp"
+#include "lfu.cpp"
+#include "lru-k.cpp"
+#include "tinylfu.cpp"
+#undef NO_MAIN
+
+using namespace std;
+
+// 缓存策略的统一接口：访问一批 key，未命中的 key 插入缓存，返回命中次数。
+// 按批调用，虚函数开销摊到每批几千次访问上
+class CachePolicy {
+public:
+    virtual ~CachePolicy() = default;
+    virtual size_t accessBatch(const uint64_t* keys, size_t n) = 0;
+    virtual size_t size() const = 0;
+};
+
+template <typename Cache>
+class PolicyAdapter : public CachePolicy {
+private:
+    Cache m_cache;
+
+public:
+    explicit PolicyAdapter(size_t capacity) : m_cache(capacity) {}
+
+    size_t accessBatch(const uint64_t* keys, size_t n) override {
+        size_t hits = 0;
+        uint64_t value;
+        for (size_t i = 0; i < n; i++) {
+            if (m_cache.get(keys[i], value)) {
+                hits++;
+            } else {
+                m_cache.put(keys[i], keys[i]);
+            }
+        }
+        return hits;
+    }
+
+    size_t size() const override {
+        return m_cache.size();
+    }
+};
+
+const vector<string> kPolicyNames = {"lru", "lru2", "lfu", "arc", "car", "tinylfu"};
+
+unique_ptr<CachePolicy> makePolicy(const string& name, size_t capacity) {
+    if (name == "lru") return make_unique<PolicyAdapter<LRUKCache<uint64_t, uint64_t, 1>>>(capacity);
+    if (name == "lru2") return make_unique<PolicyAdapter<LRUKCache<uint64_t, uint64_t, 2>>>(capacity);
+    if (name == "lfu") return make_unique<PolicyAdapter<LFUCache<uint64_t, uint64_t>>>(capacity);
+    if (name == "arc") return make_unique<PolicyAdapter<ARCache<uint64_t, uint64_t>>>(capacity);
+    if (name == "car") return make_unique<PolicyAdapter<CARCache<uint64_t, uint64_t>>>(capacity);
+    if (name == "tinylfu") return make_unique<PolicyAdapter<TinyLFUCache<uint64_t, uint64_t>>>(capacity);
+    throw invalid_argument("unknown policy: " + name);
+}
+
+// ---------------- trace 源 ----------------
+
+// 访问序列的来源，按批读出 64 位 key，读完返回 0
+class TraceSource {
+public:
+    virtual ~TraceSource() = default;
+    virtual size_t nextBatch(uint64_t* out, size_t n) = 0;
+    virtual string describe() const = 0;
+};
+
+// splitmix64 的混合函数，是 64 位上的双射：把排名/序号打散成互不相同的 key
+inline uint64_t scramble(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+inline uint64_t fnv1a(const char* p, size_t n) {
+    uint64_t h = 1469598103934665603ull;
+    for (size_t i = 0; i < n; i++) {
+        h ^= static_cast<unsigned char>(p[i]);
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+// 只读映射整个文件，顺序读取；每读过 256MB 就把已经读过的页交还内核，
+// 几十 GB 的 trace 也只占用很小的常驻内存
+class MappedFile {
+private:
+    const char* m_data = nullptr;
+    size_t m_size = 0;
+    size_t m_released = 0;
+    static constexpr size_t kReleaseChunk = 256u << 20;
+
+public:
+    explicit MappedFile(const string& path) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw runtime_error("cannot open " + path);
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            throw runtime_error("cannot stat " + path);
+        }
+        m_size = static_cast<size_t>(st.st_size);
+        if (m_size > 0) {
+            void* p = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                close(fd);
+                throw runtime_error("cannot mmap " + path);
+            }
+            m_data = static_cast<const char*>(p);
+            madvise(p, m_size, MADV_SEQUENTIAL);
+        }
+        close(fd);
+    }
+
+    ~MappedFile() {
+        if (m_data != nullptr) munmap(const_cast<char*>(m_data), m_size);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+    // 告知已经顺序读到 offset，释放之前整块的页
+    void consumed(size_t offset) {
+        size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        while (offset - m_released >= kReleaseChunk) {
+            size_t len = kReleaseChunk / page * page;
+            madvise(const_cast<char*>(m_data) + m_released, len, MADV_DONTNEED);
+            m_released += len;
+        }
+    }
+};
+
+// 二进制格式：8 字节魔数 "CTRACE1\n"，之后是小端 uint64 key 的数组
+constexpr char kBinaryMagic[8] = {'C', 'T', 'R', 'A', 'C', 'E', '1', '\n'};
+
+class BinaryTraceReader : public TraceSource {
+private:
+    string m_path;
+    MappedFile m_file;
+    size_t m_offset = sizeof(kBinaryMagic);
+
+public:
+    explicit BinaryTraceReader(const string& path) : m_path(path), m_file(path) {
+        if (m_file.size() < sizeof(kBinaryMagic) || memcmp(m_file.data(), kBinaryMagic, sizeof(kBinaryMagic)) != 0) {
+            throw runtime_error(path + ": not a binary trace");
+        }
+    }
+
+    size_t nextBatch(uint64_t* out, size_t n) override {
+        size_t avail = (m_file.size() - m_offset) / sizeof(uint64_t);
+        n = min(n, avail);
+        memcpy(out, m_file.data() + m_offset, n * sizeof(uint64_t));
+        m_offset += n * sizeof(uint64_t);
+        m_file.consumed(m_offset);
+        return n;
+    }
+
+    string describe() const override {
+        return m_path + " (binary, " + to_string((m_file.size() - sizeof(kBinaryMagic)) / 8) + " requests)";
+    }
+};
+
+// 文本格式：每行第一个空白分隔的字段是 key；纯数字按 uint64 解析，其他字符串取 FNV-1a 哈希；
+// 空行和 # 开头的行跳过
+class TextTraceReader : public TraceSource {
+private:
+    string m_path;
+    MappedFile m_file;
+    size_t m_offset = 0;
+
+public:
+    explicit TextTraceReader(const string& path) : m_path(path), m_file(path) {}
+
+    size_t nextBatch(uint64_t* out, size_t n) override {
+        const char* data = m_file.data();
+        size_t size = m_file.size(), pos = m_offset, count = 0;
+        while (count < n && pos < size) {
+            size_t lineEnd = pos;
+            while (lineEnd < size && data[lineEnd] != '\n') lineEnd++;
+            size_t b = pos;
+            while (b < lineEnd && (data[b] == ' ' || data[b] == '\t' || data[b] == '\r')) b++;
+            size_t e = b;
+            while (e < lineEnd && data[e] != ' ' && data[e] != '\t' && data[e] != '\r' && data[e] != ',') e++;
+            pos = lineEnd + 1;
+            if (e == b || data[b] == '#') continue;
+
+            uint64_t key = 0;
+            bool numeric = e - b <= 19;
+            for (size_t i = b; numeric && i < e; i++) {
+                if (data[i] < '0' || data[i] > '9') numeric = false;
+                else key = key * 10 + static_cast<uint64_t>(data[i] - '0');
+            }
+            out[count++] = numeric ? key : fnv1a(data + b, e - b);
+        }
+        m_offset = min(pos, size);
+        m_file.consumed(m_offset);
+        return count;
+    }
+
+    string describe() const override {
+        return m_path + " (text)";
+    }
+};
+
+// Zipf(alpha) 采样，用 Hörmann-Derflinger 的 rejection-inversion 方法：
+// O(1) 内存、每个样本期望常数次迭代，n 可以到数十亿而不用预先计算累积分布
+class ZipfGenerator : public TraceSource {
+private:
+    uint64_t m_n;
+    double m_alpha;
+    uint64_t m_remaining;
+    uint64_t m_length;
+    mt19937_64 m_rng;
+    uniform_real_distribution<double> m_uniform{0.0, 1.0};
+    double m_hIntegralX1, m_hIntegralN, m_s;
+
+    static double helper1(double x) {
+        return fabs(x) > 1e-8 ? log1p(x) / x : 1 - x * (0.5 - x * (1.0 / 3 - 0.25 * x));
+    }
+
+    static double helper2(double x) {
+        return fabs(x) > 1e-8 ? expm1(x) / x : 1 + x * 0.5 * (1 + x * (1.0 / 3) * (1 + 0.25 * x));
+    }
+
+    double h(double x) const {
+        return exp(-m_alpha * log(x));
+    }
+
+    double hIntegral(double x) const {
+        double logX = log(x);
+        return helper2((1 - m_alpha) * logX) * logX;
+    }
+
+    double hIntegralInverse(double x) const {
+        double t = max(x * (1 - m_alpha), -1.0);
+        return exp(helper1(t) * x);
+    }
+
+    uint64_t sample() {
+        while (true) {
+            double u = m_hIntegralN + m_uniform(m_rng) * (m_hIntegralX1 - m_hIntegralN);
+            double x = hIntegralInverse(u);
+            double k = min(max(floor(x + 0.5), 1.0), static_cast<double>(m_n));
+            if (k - x <= m_s || u >= hIntegral(k + 0.5) - h(k)) {
+                return static_cast<uint64_t>(k);
+            }
+        }
+    }
+
+public:
+    ZipfGenerator(uint64_t n, double alpha, uint64_t length, uint64_t seed)
+        : m_n(n), m_alpha(alpha), m_remaining(length), m_length(length), m_rng(seed) {
+        m_hIntegralX1 = hIntegral(1.5) - 1;
+        m_hIntegralN = hIntegral(static_cast<double>(n) + 0.5);
+        m_s = 2 - hIntegralInverse(hIntegral(2.5) - h(2));
+    }
+
+    size_t nextBatch(uint64_t* out, size_t n) override {
+        n = static_cast<size_t>(min<uint64_t>(n, m_remaining));
+        for (size_t i = 0; i < n; i++) out[i] = scramble(sample());
+        m_remaining -= n;
+        return n;
+    }
+
+    string describe() const override {
+        return "zipf n=" + to_string(m_n) + " alpha=" + to_string(m_alpha) + " len=" + to_string(m_length);
+    }
+};
+
+// 顺序扫描：每个 key 只出现一次
+class ScanGenerator : public TraceSource {
+private:
+    uint64_t m_next = 0, m_length;
+
+public:
+    explicit ScanGenerator(uint64_t length) : m_length(length) {}
+
+    size_t nextBatch(uint64_t* out, size_t n) override {
+        n = static_cast<size_t>(min<uint64_t>(n, m_length - m_next));
+        for (size_t i = 0; i < n; i++) out[i] = scramble(~(m_next++));
+        return n;
+    }
+
+    string describe() const override {
+        return "scan len=" + to_string(m_length);
+    }
+};
+
+// 循环：反复按相同顺序访问 n 个 key
+class LoopGenerator : public TraceSource {
+private:
+    uint64_t m_n, m_length, m_pos = 0;
+
+public:
+    LoopGenerator(uint64_t n, uint64_t length) : m_n(n), m_length(length) {}
+
+    size_t nextBatch(uint64_t* out, size_t n) override {
+        n = static_cast<size_t>(min<uint64_t>(n, m_length - m_pos));
+        for (size_t i = 0; i < n; i++, m_pos++) out[i] = scramble(m_pos % m_n);
+        return n;
+    }
+
+    string describe() const override {
+        return "loop n=" + to_string(m_n) + " len=" + to_string(m_length);
+    }
+};
+
+// 解析 "k=v,k=v" 形式的参数，数字允许 1e9 这样的写法
+map<string, double> parseParams(const string& text) {
+    map<string, double> params;
+    stringstream ss(text);
+    string item;
+    while (getline(ss, item, ',')) {
+        size_t eq = item.find('=');
+        if (eq == string::npos) throw invalid_argument("bad parameter: " + item);
+        params[item.substr(0, eq)] = stod(item.substr(eq + 1));
+    }
+    return params;
+}
+
+// trace 规格：zipf:n=..,alpha=..,len=..[,seed=..] | scan:len=.. | loop:n=..,len=.. |
+// 以 .bin 结尾的二进制文件 | 其他视为文本文件
+unique_ptr<TraceSource> makeSource(const string& spec) {
+    size_t colon = spec.find(':');
+    string kind = spec.substr(0, colon);
+    if (colon != string::npos && (kind == "zipf" || kind == "scan" || kind == "loop")) {
+        auto p = parseParams(spec.substr(colon + 1));
+        auto need = [&](const string& k) {
+            if (!p.count(k)) throw invalid_argument(kind + " needs " + k);
+            return p[k];
+        };
+        uint64_t len = static_cast<uint64_t>(need("len"));
+        if (kind == "zipf") {
+            uint64_t seed = p.count("seed") ? static_cast<uint64_t>(p["seed"]) : 1;
+            return make_unique<ZipfGenerator>(static_cast<uint64_t>(need("n")), need("alpha"), len, seed);
+        }
+        if (kind == "scan") return make_unique<ScanGenerator>(len);
+        return make_unique<LoopGenerator>(static_cast<uint64_t>(need("n")), len);
+    }
+    if (spec.size() > 4 && spec.compare(spec.size() - 4, 4, ".bin") == 0) {
+        return make_unique<BinaryTraceReader>(spec);
+    }
+    return make_unique<TextTraceReader>(spec);
+}
+
+// 把任意 trace 源写成二进制格式
+uint64_t convertTrace(const string& spec, const string& outPath) {
+    auto source = makeSource(spec);
+    FILE* out = fopen(outPath.c_str(), "wb");
+    if (out == nullptr) throw runtime_error("cannot create " + outPath);
+    fwrite(kBinaryMagic, 1, sizeof(kBinaryMagic), out);
+    vector<uint64_t> batch(1 << 16);
+    uint64_t total = 0;
+    while (size_t n = source->nextBatch(batch.data(), batch.size())) {
+        fwrite(batch.data(), sizeof(uint64_t), n, out);
+        total += n;
+    }
+    fclose(out);
+    return total;
+}
+
+// ---------------- 驱动 ----------------
+
+size_t mallocBytes() {
+    struct mallinfo2 mi = mallinfo2();
+    return mi.uordblks + mi.hblkhd;
+}
+
+struct SimResult {
+    string policy;
+    size_t capacity;
+    uint64_t requests = 0;
+    uint64_t hits = 0;
+    double seconds = 0;
+    double bytesPerEntry = 0;
+};
+
+// 单独构造一个缓存，用 trace 开头的 10*capacity 个请求把它填满，按堆增量估算每个条目的字节数
+double measureBytesPerEntry(const string& spec, const string& policy, size_t capacity) {
+    auto source = makeSource(spec);
+    vector<uint64_t> batch(4096);
+    size_t before = mallocBytes();
+    auto cache = makePolicy(policy, capacity);
+    uint64_t fed = 0;
+    while (fed < 10 * static_cast<uint64_t>(capacity)) {
+        size_t n = source->nextBatch(batch.data(), batch.size());
+        if (n == 0) break;
+        cache->accessBatch(batch.data(), n);
+        fed += n;
+    }
+    size_t bytes = mallocBytes() - before;
+    return cache->size() > 0 ? static_cast<double>(bytes) / cache->size() : 0;
+}
+
+// 所有 (策略, 容量) 组合在同一趟读取中一起回放：trace 只读一遍，按批分发给每个缓存，
+// 每个缓存只累计自己处理批次的耗时
+vector<SimResult> simulate(const string& spec, const vector<string>& policies, const vector<size_t>& capacities) {
+    vector<SimResult> results;
+    vector<unique_ptr<CachePolicy>> caches;
+    for (const string& policy : policies) {
+        for (size_t capacity : capacities) {
+            SimResult r;
+            r.policy = policy;
+            r.capacity = capacity;
+            r.bytesPerEntry = measureBytesPerEntry(spec, policy, capacity);
+            results.push_back(r);
+        }
+    }
+    for (const SimResult& r : results) caches.push_back(makePolicy(r.policy, r.capacity));
+
+    auto source = makeSource(spec);
+    cout << "trace: " << source->describe() << endl;
+    vector<uint64_t> batch(4096);
+    uint64_t total = 0, nextReport = 1ull << 27;
+    while (size_t n = source->nextBatch(batch.data(), batch.size())) {
+        for (size_t i = 0; i < caches.size(); i++) {
+            auto start = chrono::steady_clock::now();
+            results[i].hits += caches[i]->accessBatch(batch.data(), n);
+            results[i].seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            results[i].requests += n;
+        }
+        total += n;
+        if (total >= nextReport) {
+            cerr << "  " << total << " requests replayed" << endl;
+            nextReport += 1ull << 27;
+        }
+    }
+    return results;
+}
+
+// 输出三张表：命中率-容量曲线、吞吐、每条目字节数；行为容量，列为策略
+void printResults(const vector<SimResult>& results, const vector<string>& policies,
+                  const vector<size_t>& capacities) {
+    auto find = [&](const string& policy, size_t capacity) -> const SimResult& {
+        for (const SimResult& r : results) {
+            if (r.policy == policy && r.capacity == capacity) return r;
+        }
+        throw logic_error("missing result");
+    };
+    auto table = [&](const char* title, auto value) {
+        cout << title << endl << setw(10) << "capacity";
+        for (const string& p : policies) cout << setw(12) << p;
+        cout << endl;
+        for (size_t c : capacities) {
+            cout << setw(10) << c;
+            for (const string& p : policies) cout << setw(12) << value(find(p, c));
+            cout << endl;
+        }
+    };
+    cout << fixed << setprecision(4);
+    table("hit ratio", [](const SimResult& r) { return r.requests ? static_cast<double>(r.hits) / r.requests : 0.0; });
+    cout << setprecision(0);
+    table("ops/s", [](const SimResult& r) { return r.seconds > 0 ? r.requests / r.seconds : 0.0; });
+    cout << setprecision(1);
+    table("bytes/entry", [](const SimResult& r) { return r.bytesPerEntry; });
+    cout << defaultfloat;
+}
+
+vector<string> splitList(const string& text) {
+    vector<string> items;
+    stringstream ss(text);
+    string item;
+    while (getline(ss, item, ',')) {
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+void usage() {
+    cerr << "usage:\n"
+            "  cache-sim [-p lru,lru2,lfu,arc,car,tinylfu] [-c 1000,10000,...] <trace>\n"
+            "  cache-sim --convert <trace> <out.bin>\n"
+            "trace: zipf:n=1e6,alpha=0.9,len=1e8[,seed=1] | scan:len=.. | loop:n=..,len=.. | file.bin | file.txt\n"
+            "no arguments: run the built-in synthetic comparison\n";
+}
+
+int main(int argc, char** argv) {
+    try {
+        if (argc == 4 && string(argv[1]) == "--convert") {
+            uint64_t n = convertTrace(argv[2], argv[3]);
+            cout << "wrote " << n << " requests to " << argv[3] << endl;
+            return 0;
+        }
+
+        vector<string> policies = kPolicyNames;
+        vector<size_t> capacities = {10000, 50000, 100000, 200000};
+        vector<string> traces;
+        for (int i = 1; i < argc; i++) {
+            string arg = argv[i];
+            if ((arg == "-p" || arg == "-c") && i + 1 < argc) {
+                if (arg == "-p") {
+                    policies = splitList(argv[++i]);
+                } else {
+                    capacities.clear();
+                    for (const string& c : splitList(argv[++i])) capacities.push_back(static_cast<size_t>(stod(c)));
+                }
+            } else if (arg[0] == '-') {
+                usage();
+                return 1;
+            } else {
+                traces.push_back(arg);
+            }
+        }
+        if (traces.empty()) {
+            traces = {"zipf:n=1e6,alpha=0.8,len=5e6", "zipf:n=1e6,alpha=1.0,len=5e6", "loop:n=125000,len=5e6"};
+        }
+        for (const string& spec : traces) {
+            printResults(simulate(spec, policies, capacities), policies, capacities);
+        }
+        // trace 是流式读取的，峰值内存只取决于缓存本身
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        cout << "peak RSS: " << usage.ru_maxrss / 1024 << " MB" << endl;
+    } catch (const exception& e) {
+        cerr << "error: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
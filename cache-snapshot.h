@@ -0,0 +1,242 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// 缓存快照文件：发布重启前把驻留条目连同替换策略的状态写进一个紧凑的二进制文件，
+// 启动时 mmap 进来顺序解析，缓存不用从零开始预热。
+// 文件布局：8 字节魔数、格式版本、保存时的系统时间（毫秒），之后是各缓存自己的内容，
+// 最后是 8 字节结束标记，用来发现写了一半的文件。整数按本机字节序写入，快照只在同一种机器间迁移。
+// 写入先落到 path.tmp，commit 时再 rename 覆盖，进程中途退出不会留下残缺的快照。
+// 条目的剩余 TTL 按写入时刻换算成相对值保存，读入时再扣掉两次启动之间经过的系统时间
+
+// 默认的 key/value 序列化：平凡可复制的类型按字节原样写入，std::string 写长度加内容。
+// 其它类型由调用方提供同样形式的序列化器：write(SnapshotWriter&, const T&) 和 read(SnapshotReader&, T&)
+template <typename T, typename Enable = void>
+struct SnapshotSerializer;
+
+inline constexpr char kSnapshotEnd[8] = {'S', 'N', 'A', 'P', '-', 'E', 'N', 'D'};
+
+class SnapshotWriter {
+private:
+    static constexpr uint32_t kVersion = 1;
+    static constexpr size_t kBufferSize = 1 << 20;
+
+    std::string path;
+    std::string tmpPath;
+    int fd;
+    std::vector<char> buffer;
+    uint64_t flushed = 0;  // 已经写进文件的字节数
+    bool committed = false;
+
+    void flush() {
+        size_t done = 0;
+        while (done < buffer.size()) {
+            ssize_t n = ::write(fd, buffer.data() + done, buffer.size() - done);
+            if (n < 0) throw std::runtime_error("snapshot write failed: " + tmpPath);
+            done += static_cast<size_t>(n);
+        }
+        flushed += buffer.size();
+        buffer.clear();
+    }
+
+public:
+    SnapshotWriter(const std::string& file, const char (&magic)[9])
+        : path(file), tmpPath(file + ".tmp") {
+        fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) throw std::runtime_error("cannot create snapshot: " + tmpPath);
+        buffer.reserve(kBufferSize);
+        raw(magic, 8);
+        put(kVersion);
+        put(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count()));
+    }
+
+    // 没有 commit 就析构（例如序列化时抛出异常）时丢掉临时文件
+    ~SnapshotWriter() {
+        if (fd >= 0) ::close(fd);
+        if (!committed) ::unlink(tmpPath.c_str());
+    }
+
+    SnapshotWriter(const SnapshotWriter&) = delete;
+    SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+    void raw(const void* data, size_t n) {
+        if (buffer.size() + n > kBufferSize) {
+            flush();
+            if (n > kBufferSize) {
+                buffer.assign(static_cast<const char*>(data), static_cast<const char*>(data) + n);
+                flush();
+                return;
+            }
+        }
+        buffer.insert(buffer.end(), static_cast<const char*>(data), static_cast<const char*>(data) + n);
+    }
+
+    template <typename T>
+    void put(const T& v) {
+        static_assert(std::is_trivially_copyable_v<T>, "put() writes raw bytes");
+        raw(&v, sizeof(T));
+    }
+
+    // 先写一个占位的 T，返回它在文件中的位置，内容写完后再用 patch 填入，
+    // 用于事先不知道的个数，省得为了计数把数据多遍历一遍
+    template <typename T>
+    uint64_t reserve() {
+        uint64_t at = flushed + buffer.size();
+        put(T{});
+        return at;
+    }
+
+    template <typename T>
+    void patch(uint64_t at, const T& v) {
+        static_assert(std::is_trivially_copyable_v<T>, "patch() writes raw bytes");
+        if (at >= flushed) {
+            std::memcpy(buffer.data() + (at - flushed), &v, sizeof(T));
+        } else if (::pwrite(fd, &v, sizeof(T), static_cast<off_t>(at)) != static_cast<ssize_t>(sizeof(T))) {
+            throw std::runtime_error("snapshot write failed: " + tmpPath);
+        }
+    }
+
+    // 写结束标记并把临时文件换成正式文件
+    void commit() {
+        raw(kSnapshotEnd, sizeof(kSnapshotEnd));
+        flush();
+        int rc = ::close(fd);
+        fd = -1;
+        if (rc != 0 || std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+            throw std::runtime_error("cannot commit snapshot: " + path);
+        }
+        committed = true;
+    }
+};
+
+class SnapshotReader {
+private:
+    const char* base = nullptr;
+    size_t mapped = 0;
+    size_t length = 0;  // 不含结束标记
+    size_t pos = 0;
+    uint64_t savedAtMs = 0;
+
+    [[noreturn]] static void corrupt(const char* what) {
+        throw std::runtime_error(std::string("corrupt snapshot: ") + what);
+    }
+
+public:
+    SnapshotReader(const std::string& path, const char (&magic)[9]) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("cannot open snapshot: " + path);
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error("cannot stat snapshot: " + path);
+        }
+        length = mapped = static_cast<size_t>(st.st_size);
+        if (mapped > 0) {
+            void* p = ::mmap(nullptr, mapped, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("cannot map snapshot: " + path);
+            }
+            // 顺序读一遍：提前预读，读过的页面尽早回收
+            ::madvise(p, mapped, MADV_SEQUENTIAL);
+            ::madvise(p, mapped, MADV_WILLNEED);
+            base = static_cast<const char*>(p);
+        }
+        ::close(fd);
+        if (length < 8 + sizeof(uint32_t) + sizeof(uint64_t) + sizeof(kSnapshotEnd) ||
+            std::memcmp(base + length - sizeof(kSnapshotEnd), kSnapshotEnd, sizeof(kSnapshotEnd)) != 0) {
+            release();
+            corrupt("truncated");
+        }
+        length -= sizeof(kSnapshotEnd);
+        if (std::memcmp(take(8), magic, 8) != 0) {
+            release();
+            corrupt("wrong magic");
+        }
+        if (get<uint32_t>() != 1) {
+            release();
+            corrupt("unsupported version");
+        }
+        savedAtMs = get<uint64_t>();
+    }
+
+    ~SnapshotReader() { release(); }
+
+    SnapshotReader(const SnapshotReader&) = delete;
+    SnapshotReader& operator=(const SnapshotReader&) = delete;
+
+    void release() {
+        if (base != nullptr) ::munmap(const_cast<char*>(base), mapped);
+        base = nullptr;
+    }
+
+    // 返回接下来 n 个字节的位置并跳过它们，指针在 reader 析构前有效
+    const char* take(size_t n) {
+        if (n > length - pos) corrupt("read past end");
+        const char* p = base + pos;
+        pos += n;
+        return p;
+    }
+
+    void raw(void* out, size_t n) {
+        std::memcpy(out, take(n), n);
+    }
+
+    template <typename T>
+    T get() {
+        static_assert(std::is_trivially_copyable_v<T>, "get() reads raw bytes");
+        T v;
+        raw(&v, sizeof(T));
+        return v;
+    }
+
+    // 元素个数：每个元素至少占 minBytes 字节，超过剩余长度的计数说明文件已损坏，不能拿去预留内存
+    uint64_t count(size_t minBytes = 0) {
+        uint64_t n = get<uint64_t>();
+        if (minBytes != 0 && n > (length - pos) / minBytes) corrupt("bad element count");
+        return n;
+    }
+
+    // 内容应当恰好读完
+    void finish() {
+        if (pos != length) corrupt("trailing bytes");
+    }
+
+    // 保存快照以来经过的系统时间，时钟回拨时为 0
+    uint64_t elapsedMs() const {
+        uint64_t nowMs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+        return nowMs > savedAtMs ? nowMs - savedAtMs : 0;
+    }
+};
+
+template <typename T>
+struct SnapshotSerializer<T, std::enable_if_t<std::is_trivially_copyable_v<T>>> {
+    void write(SnapshotWriter& out, const T& v) const { out.put(v); }
+    void read(SnapshotReader& in, T& v) const { in.raw(&v, sizeof(T)); }
+};
+
+template <>
+struct SnapshotSerializer<std::string> {
+    void write(SnapshotWriter& out, const std::string& s) const {
+        out.put(static_cast<uint32_t>(s.size()));
+        out.raw(s.data(), s.size());
+    }
+    void read(SnapshotReader& in, std::string& s) const {
+        uint32_t n = in.get<uint32_t>();
+        s.assign(in.take(n), n);
+    }
+};
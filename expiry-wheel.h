@@ -0,0 +1,122 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <utility>
+#include <vector>
+
+// 缓存条目过期用的粗粒度时间轮。
+// 槽位按 tick（默认 100ms）划分，schedule 把 (key, 截止时间) 放进截止时间向上取整后的 tick 对应的槽位，
+// 超过一圈的记录留在槽里，转到它所在的那一圈才处理。advance 每次最多检查 budget 条记录，
+// 缓存可以在 get/put 里顺带推进，把清理开销摊到每次操作上而不必全表扫描。
+// 时间轮只保存 key 和截止时间，不持有条目指针：条目被更新、淘汰或提前过期后留下的旧记录，
+// 到期时由回调按截止时间比对后忽略即可。TTL 很长而写入频繁时旧记录会堆积，
+// 缓存在记录数超过有效条目数的两倍时调用 compact 清掉它们，均摊到每次写入仍是 O(1)
+template <typename Key>
+class ExpiryWheel {
+private:
+    struct Item {
+        Key key;
+        uint64_t deadline;  // 毫秒
+        uint64_t tick;      // 所在的 tick，超过一圈时大于当前这一圈
+    };
+
+    uint64_t tickMs;
+    std::vector<std::vector<Item>> slots;  // 第一次 schedule 时才分配，不用 TTL 的缓存不占这部分内存
+    size_t mask;
+    uint64_t cursor;      // 下一个要处理的 tick
+    size_t scanPos = 0;   // cursor 所在槽位已经检查到的位置，预算用完时从这里继续
+    size_t count = 0;
+
+public:
+    // 单调时钟的毫秒数，缓存里的截止时间都以它为准。命中带 TTL 的条目时每次都要读时钟，
+    // Linux 上用粗粒度时钟（精度为一个调度节拍，读一次约 10ns，steady_clock 要 40ns 左右）
+    static uint64_t now() {
+#ifdef CLOCK_MONOTONIC_COARSE
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000 + static_cast<uint64_t>(ts.tv_nsec) / 1000000;
+#else
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+    }
+
+    // slotCount 向上取整到 2 的幂
+    explicit ExpiryWheel(uint64_t tick = 100, size_t slotCount = 1024)
+        : tickMs(tick == 0 ? 1 : tick), cursor(now() / tickMs) {
+        size_t n = 1;
+        while (n < slotCount) n <<= 1;
+        mask = n - 1;
+    }
+
+    bool empty() const { return count == 0; }
+
+    // 尚未处理的记录数（含已经失效的旧记录）
+    size_t size() const { return count; }
+
+    void schedule(const Key& key, uint64_t deadline) {
+        uint64_t tick = (deadline + tickMs - 1) / tickMs;
+        if (tick < cursor) tick = cursor;  // 已经过期，放进当前槽位尽快处理
+        if (slots.empty()) slots.resize(mask + 1);
+        slots[tick & mask].push_back(Item{key, deadline, tick});
+        count++;
+    }
+
+    // 只保留 isLive(key, deadline) 为 true 的记录
+    template <typename IsLive>
+    void compact(IsLive&& isLive) {
+        size_t kept = 0;
+        for (std::vector<Item>& slot : slots) {
+            size_t n = 0;
+            for (Item& item : slot) {
+                if (!isLive(item.key, item.deadline)) continue;
+                if (&slot[n] != &item) slot[n] = std::move(item);
+                n++;
+            }
+            slot.erase(slot.begin() + n, slot.end());
+            if (slot.capacity() > 64 && n < slot.capacity() / 4) slot.shrink_to_fit();
+            kept += n;
+        }
+        count = kept;
+        scanPos = 0;  // 顺序变了，当前槽位从头再扫一遍
+    }
+
+    // 处理截止到 nowMs 的记录，对每条到期记录调用 onExpire(key, deadline)。
+    // 最多检查 budget 条记录，全部处理完返回 true
+    template <typename OnExpire>
+    bool advance(uint64_t nowMs, size_t budget, OnExpire&& onExpire) {
+        uint64_t nowTick = nowMs / tickMs;
+        if (count == 0) {
+            cursor = nowTick + 1;
+            scanPos = 0;
+            return true;
+        }
+        // 停顿超过一圈时，最近一圈的槽位已经覆盖全部记录，前面的 tick 不必逐个走
+        if (scanPos == 0 && nowTick > cursor + mask) {
+            cursor = nowTick - mask;
+        }
+        while (cursor <= nowTick) {
+            std::vector<Item>& slot = slots[cursor & mask];
+            while (scanPos < slot.size()) {
+                if (budget == 0) return false;
+                budget--;
+                if (slot[scanPos].tick > nowTick) {
+                    scanPos++;  // 属于以后的某一圈
+                    continue;
+                }
+                Item item = std::move(slot[scanPos]);
+                if (scanPos + 1 != slot.size()) slot[scanPos] = std::move(slot.back());
+                slot.pop_back();
+                count--;
+                onExpire(item.key, item.deadline);
+            }
+            // 过期高峰过后归还槽位内存
+            if (slot.capacity() > 64 && slot.size() < slot.capacity() / 4) slot.shrink_to_fit();
+            scanPos = 0;
+            cursor++;
+        }
+        return true;
+    }
+};
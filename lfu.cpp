@@ -1,65 +1,512 @@
 #include <bits/stdc++.h>
+
+#include "expiry-wheel.h"
+#include "cache-snapshot.h"
+
 using namespace std;
 
+// O(1) LFU：频次节点按访问次数升序串成双向链表，每个频次节点下挂一条该频次条目的侵入式双向链表
+// （表头最旧，同频次内按 LRU 淘汰）。命中时条目移到下一个频次节点（不存在则新建），
+// 原频次节点空了就删除，最小频次永远是链表头，不需要扫描。
+// agingPeriod 不为 0 时，每 agingPeriod 次访问把所有计数减半（至少为 1），
+// 很久以前很热、现在不再访问的 key 会逐渐让出缓存。
+// put 可以带 TTL，过期条目在访问时惰性删除，其余由时间轮在 put 中顺带清理。
+// 过期时间单独放在一张只记录带 TTL 条目的表里，条目本身不变大。
+// saveSnapshot/loadSnapshot 把条目连同访问计数和同频次内的先后顺序存进文件再读回来
+template <typename Key, typename Value, typename Hash = hash<Key>, typename KeyEqual = equal_to<Key>>
 class LFUCache {
 private:
-    unordered_map<int,pair<int,int>>keyVals; // key->{value,cnt}
-    unordered_map<int,list<int>::iterator> keyIters; // key->iterator
-    unordered_map<int,list<int>>keyCnts; // cnt->list
-    int m_capacity;
-    int mincnt;
-    void touch(int key){
-        int cnt=keyVals[key].second;
-        keyVals[key].second++;
-        keyCnts[cnt].erase(keyIters[key]);
-        keyCnts[cnt+1].push_back(key);
-        keyIters[key]=--keyCnts[cnt+1].end();
-
-        while(keyCnts[mincnt].empty()){
-            mincnt++;
+    struct FreqNode;
+
+    struct Entry {
+        Key key;
+        Value value;
+        FreqNode* freq;
+        Entry* prev;
+        Entry* next;
+    };
+
+    struct FreqNode {
+        uint64_t count;
+        Entry* head;  // 最久未访问
+        Entry* tail;
+        FreqNode* prev;
+        FreqNode* next;
+    };
+
+    size_t m_capacity;
+    uint64_t m_agingPeriod;
+    uint64_t m_accesses = 0;
+
+    unordered_map<Key, Entry*, Hash, KeyEqual> m_entries;
+    FreqNode* m_minFreq = nullptr;  // 频次链表头，计数最小
+
+    // 带 TTL 条目的时间轮，每 kExpiryInterval 次 put 推进一次，每次最多检查 kExpiryBudget 条记录
+    static constexpr uint32_t kExpiryInterval = 16;
+    static constexpr size_t kExpiryBudget = 32;
+    ExpiryWheel<Key> m_expiry;
+    unordered_map<Key, uint64_t, Hash, KeyEqual> m_deadlines;  // 带 TTL 条目的过期时间（ExpiryWheel::now() 的毫秒数）
+    uint32_t m_expiryOps = 0;
+    uint64_t m_expired = 0;
+
+    // 在 after 之后插入一个新的频次节点，after 为空时插到表头
+    FreqNode* insertFreq(FreqNode* after, uint64_t count) {
+        FreqNode* f = new FreqNode{count, nullptr, nullptr, after, after != nullptr ? after->next : m_minFreq};
+        if (f->next != nullptr) f->next->prev = f;
+        if (after != nullptr) after->next = f; else m_minFreq = f;
+        return f;
+    }
+
+    void eraseFreq(FreqNode* f) {
+        if (f->prev != nullptr) f->prev->next = f->next; else m_minFreq = f->next;
+        if (f->next != nullptr) f->next->prev = f->prev;
+        delete f;
+    }
+
+    void pushBack(FreqNode* f, Entry* e) {
+        e->freq = f;
+        e->prev = f->tail;
+        e->next = nullptr;
+        if (f->tail != nullptr) f->tail->next = e; else f->head = e;
+        f->tail = e;
+    }
+
+    void unlink(Entry* e) {
+        FreqNode* f = e->freq;
+        if (e->prev != nullptr) e->prev->next = e->next; else f->head = e->next;
+        if (e->next != nullptr) e->next->prev = e->prev; else f->tail = e->prev;
+    }
+
+    // 访问次数加一：移到 count+1 的频次节点尾部，原节点空了就删除
+    void touch(Entry* e) {
+        FreqNode* f = e->freq;
+        FreqNode* next = f->next;
+        if (next == nullptr || next->count != f->count + 1) {
+            next = insertFreq(f, f->count + 1);
+        }
+        unlink(e);
+        pushBack(next, e);
+        if (f->head == nullptr) eraseFreq(f);
+        countAccess();
+    }
+
+    void countAccess() {
+        if (m_agingPeriod != 0 && ++m_accesses >= m_agingPeriod) {
+            m_accesses = 0;
+            age();
+        }
+    }
+
+    // 所有计数减半。减半保持频次节点的先后顺序，只需把减半后计数相同的相邻节点合并：
+    // 原计数较小的条目排在前面，先被淘汰
+    void age() {
+        for (FreqNode* f = m_minFreq; f != nullptr; f = f->next) {
+            f->count = max<uint64_t>(f->count / 2, 1);
+            FreqNode* prev = f->prev;
+            if (prev == nullptr || prev->count != f->count) continue;
+            for (Entry* e = f->head; e != nullptr; e = e->next) e->freq = prev;
+            prev->tail->next = f->head;
+            f->head->prev = prev->tail;
+            prev->tail = f->tail;
+            FreqNode* merged = f;
+            f = prev;
+            eraseFreq(merged);
         }
     }
+
+    void remove(Entry* e) {
+        FreqNode* f = e->freq;
+        unlink(e);
+        if (f->head == nullptr) eraseFreq(f);
+        if (!m_deadlines.empty()) m_deadlines.erase(e->key);
+        m_entries.erase(e->key);
+        delete e;
+    }
+
+    void evict() {
+        remove(m_minFreq->head);
+    }
+
+    bool isExpired(const Key& key) const {
+        auto it = m_deadlines.find(key);
+        return it != m_deadlines.end() && it->second <= ExpiryWheel<Key>::now();
+    }
+
+    // 时间轮里的记录仍对应当前条目（没有被更新或删除过）
+    Entry* liveEntry(const Key& key, uint64_t deadline) const {
+        auto it = m_deadlines.find(key);
+        return it != m_deadlines.end() && it->second == deadline ? m_entries.find(key)->second : nullptr;
+    }
+
+    // 过期处理都是冷路径，不内联进 get/put
+    __attribute__((noinline)) void expire(Entry* e) {
+        m_expired++;
+        remove(e);
+    }
+
+    // 已经过期时删除条目并返回 true
+    __attribute__((noinline)) bool expireIfDue(Entry* e) {
+        if (!isExpired(e->key)) return false;
+        expire(e);
+        return true;
+    }
+
+    __attribute__((noinline)) void advanceExpiry(size_t budget) {
+        m_expiry.advance(ExpiryWheel<Key>::now(), budget, [this](const Key& key, uint64_t deadline) {
+            if (Entry* e = liveEntry(key, deadline)) expire(e);
+        });
+    }
+
+    void maintainExpiry() {
+        if (m_expiry.empty() || ++m_expiryOps < kExpiryInterval) return;
+        m_expiryOps = 0;
+        advanceExpiry(kExpiryBudget);
+    }
+
+    // 设置或更新缓存值，返回存放它的条目；容量为 0 时返回 nullptr
+    Entry* store(const Key& key, const Value& value) {
+        if (m_capacity == 0) return nullptr;
+
+        auto it = m_entries.find(key);
+        if (it != m_entries.end()) {
+            it->second->value = value;
+            touch(it->second);
+            return it->second;
+        }
+
+        if (m_entries.size() == m_capacity) evict();
+        FreqNode* f = m_minFreq;
+        if (f == nullptr || f->count != 1) f = insertFreq(nullptr, 1);
+        Entry* e = new Entry{key, value, nullptr, nullptr, nullptr};
+        pushBack(f, e);
+        m_entries.emplace(key, e);
+        countAccess();
+        return e;
+    }
+
+    // 按频次链表释放，读快照时条目先挂进链表、后放进 m_entries，中途出错也不会漏掉
+    void deleteEntries() {
+        while (m_minFreq != nullptr) {
+            for (Entry* e = m_minFreq->head; e != nullptr;) {
+                Entry* next = e->next;
+                delete e;
+                e = next;
+            }
+            FreqNode* next = m_minFreq->next;
+            delete m_minFreq;
+            m_minFreq = next;
+        }
+    }
+
+    // 按桶的位置分段插入：随机顺序插入 unordered_map 时几乎每次都访问一个冷的桶，
+    // 先按桶号把条目分到 kRestoreRanges 段，每段只涉及一小片连续的桶数组
+    void indexEntries(const vector<Entry*>& loaded) {
+        static constexpr size_t kRestoreRanges = 4096;
+        m_entries.reserve(max(m_capacity, loaded.size()));
+        size_t buckets = m_entries.bucket_count();
+        auto rangeOf = [&](const Entry* e) {
+            return static_cast<size_t>(static_cast<unsigned __int128>(m_entries.bucket(e->key)) * kRestoreRanges / buckets);
+        };
+        vector<size_t> starts(kRestoreRanges + 1, 0);
+        for (const Entry* e : loaded) starts[rangeOf(e) + 1]++;
+        for (size_t r = 0; r < kRestoreRanges; r++) starts[r + 1] += starts[r];
+        vector<Entry*> ordered(loaded.size());
+        for (Entry* e : loaded) ordered[starts[rangeOf(e)]++] = e;
+        for (Entry* e : ordered) {
+            if (!m_entries.emplace(e->key, e).second) throw runtime_error("corrupt snapshot: duplicate key");
+        }
+    }
+
+    static constexpr char kSnapshotMagic[9] = "LFUSNAP1";
+
+    // 频次节点按计数升序读入，节点内按从旧到新的顺序读入，依次接到末尾
+    template <typename KeySerializer, typename ValueSerializer>
+    void restore(SnapshotReader& in, const KeySerializer& ks, const ValueSerializer& vs) {
+        in.get<uint64_t>();  // 保存时的容量，读入后按当前容量淘汰
+        uint64_t accesses = in.get<uint64_t>();
+        bool withTtl = in.get<uint8_t>() != 0;
+        uint64_t elapsed = in.elapsedMs();
+        uint64_t now = ExpiryWheel<Key>::now();
+        Key key{};
+        Value value{};
+
+        vector<Entry*> loaded;
+        FreqNode* last = nullptr;
+        uint64_t nodes = in.count();
+        for (uint64_t i = 0; i < nodes; i++) {
+            uint64_t count = in.get<uint64_t>();
+            if (count == 0 || (last != nullptr && count <= last->count)) {
+                throw runtime_error("corrupt snapshot: frequencies out of order");
+            }
+            FreqNode* f = nullptr;
+            uint64_t n = in.count();
+            for (uint64_t j = 0; j < n; j++) {
+                ks.read(in, key);
+                vs.read(in, value);
+                uint64_t remaining = withTtl ? in.get<uint64_t>() : 0;
+                if (remaining != 0 && remaining <= elapsed) continue;  // 停机期间已经过期
+                if (f == nullptr) f = last = insertFreq(last, count);
+                Entry* e = new Entry{key, value, nullptr, nullptr, nullptr};
+                pushBack(f, e);
+                loaded.push_back(e);
+                if (remaining != 0) {
+                    m_deadlines[key] = now + remaining - elapsed;
+                    m_expiry.schedule(key, now + remaining - elapsed);
+                }
+            }
+        }
+        in.finish();
+        indexEntries(loaded);
+
+        m_accesses = m_agingPeriod != 0 && accesses < m_agingPeriod ? accesses : 0;
+        while (m_entries.size() > m_capacity) evict();
+    }
+
 public:
-    LFUCache(int capacity):m_capacity(capacity),mincnt(0) {}
-    
-    int get(int key) {
-        if(!keyVals.contains(key)) return -1;
-        touch(key);
-        return keyVals[key].first;
-    }
-    
-    void put(int key, int value) {
-        if(m_capacity<=0) return;
-
-        if(keyVals.contains(key)){
-            keyVals[key].first=value;
-            touch(key);
-        }
-        else{
-            if(m_capacity==keyVals.size()){
-               auto lastkey= keyCnts[mincnt].front();
-               keyVals.erase(lastkey);
-               keyIters.erase(lastkey);
-               keyCnts[mincnt].pop_front();
+    // agingPeriod 为 0 表示不做计数衰减
+    LFUCache(size_t capacity, uint64_t agingPeriod = 0) : m_capacity(capacity), m_agingPeriod(agingPeriod) {
+        m_entries.reserve(capacity);
+    }
+
+    ~LFUCache() {
+        deleteEntries();
+    }
+
+    LFUCache(const LFUCache&) = delete;
+    LFUCache& operator=(const LFUCache&) = delete;
+
+    // 获取缓存值，命中返回 true
+    bool get(const Key& key, Value& value) {
+        auto it = m_entries.find(key);
+        if (it == m_entries.end()) return false;
+        Entry* e = it->second;
+        if (!m_deadlines.empty() && expireIfDue(e)) return false;
+        value = e->value;
+        touch(e);
+        return true;
+    }
+
+    // 获取缓存值，如果不存在返回默认构造的值
+    Value get(const Key& key) {
+        Value value{};
+        get(key, value);
+        return value;
+    }
+
+    // 设置或更新缓存值，不过期；覆盖带 TTL 的旧值时取消它的过期时间
+    void put(const Key& key, const Value& value) {
+        maintainExpiry();
+        store(key, value);
+        if (!m_deadlines.empty()) m_deadlines.erase(key);
+    }
+
+    // 设置或更新缓存值，ttl 之后过期
+    void put(const Key& key, const Value& value, chrono::milliseconds ttl) {
+        maintainExpiry();
+        if (store(key, value) == nullptr) return;
+        // ttl 不大于 0 时下次访问即过期
+        uint64_t deadline = ExpiryWheel<Key>::now() + max<int64_t>(ttl.count(), 0);
+        m_deadlines[key] = deadline;
+        m_expiry.schedule(key, deadline);
+        // 被更新或淘汰的条目在时间轮里留下旧记录，超过有效条目两倍时清理一次
+        if (m_expiry.size() > 2 * m_deadlines.size() + 1024) {
+            m_expiry.compact([this](const Key& k, uint64_t deadline) { return liveEntry(k, deadline) != nullptr; });
+        }
+    }
+
+    // 立即删除已经过期的条目，返回删除的个数；精度为时间轮的一个 tick
+    size_t removeExpired() {
+        uint64_t before = m_expired;
+        advanceExpiry(SIZE_MAX);
+        return static_cast<size_t>(m_expired - before);
+    }
+
+    bool contains(const Key& key) const {
+        auto it = m_entries.find(key);
+        return it != m_entries.end() && !isExpired(key);
+    }
+
+    // 返回 key 当前的访问计数，不存在时返回 0
+    uint64_t frequency(const Key& key) const {
+        auto it = m_entries.find(key);
+        return it == m_entries.end() ? 0 : it->second->freq->count;
+    }
+
+    // 包含已过期但还没被清理的条目
+    size_t size() const {
+        return m_entries.size();
+    }
+
+    // 因 TTL 到期被删除的条目数
+    uint64_t expiredCount() const {
+        return m_expired;
+    }
+
+    // 清空缓存和过期记录
+    void clear() {
+        deleteEntries();
+        m_entries.clear();
+        m_deadlines.clear();
+        m_expiry = ExpiryWheel<Key>();
+        m_expiryOps = 0;
+        m_accesses = 0;
+    }
+
+    // 把条目和访问计数写入快照文件：频次节点按计数升序写出，节点内从旧到新，已经过期的条目不写。
+    // key/value 的序列化器可以替换，默认支持平凡可复制类型和 std::string
+    template <typename KeySerializer = SnapshotSerializer<Key>,
+              typename ValueSerializer = SnapshotSerializer<Value>>
+    void saveSnapshot(const string& path, const KeySerializer& ks = KeySerializer(),
+                      const ValueSerializer& vs = ValueSerializer()) const {
+        SnapshotWriter out(path, kSnapshotMagic);
+        uint64_t now = ExpiryWheel<Key>::now();
+        // 没有带 TTL 的条目时不写剩余时间，每个条目省 8 字节
+        bool withTtl = !m_deadlines.empty();
+        out.put<uint64_t>(m_capacity);
+        out.put<uint64_t>(m_accesses);
+        out.put<uint8_t>(withTtl);
+        auto remainingOf = [&](const Entry* e) -> uint64_t {
+            auto it = m_deadlines.find(e->key);
+            return it == m_deadlines.end() ? 0 : it->second > now ? it->second - now : UINT64_MAX;
+        };
+        uint64_t nodes = 0;
+        for (FreqNode* f = m_minFreq; f != nullptr; f = f->next) nodes++;
+        out.put(nodes);
+        for (FreqNode* f = m_minFreq; f != nullptr; f = f->next) {
+            out.put(f->count);
+            uint64_t at = out.reserve<uint64_t>();
+            uint64_t n = 0;
+            for (Entry* e = f->head; e != nullptr; e = e->next) {
+                uint64_t remaining = withTtl ? remainingOf(e) : 0;
+                if (remaining == UINT64_MAX) continue;
+                ks.write(out, e->key);
+                vs.write(out, e->value);
+                if (withTtl) out.put(remaining);
+                n++;
             }
-            keyVals[key]={value,1};
-            keyCnts[1].push_back(key);
-            keyIters[key]=--keyCnts[1].end();
-            mincnt=1;
+            out.patch(at, n);
+        }
+        out.commit();
+    }
+
+    // 用快照文件的内容替换当前缓存，容量比保存时小就按 LFU 规则淘汰多出的条目；
+    // 停机期间 TTL 已经耗尽的条目丢弃。文件打不开或文件头不对时抛出 runtime_error，缓存不变；
+    // 内容在解析中途出错时同样抛出，缓存留空
+    template <typename KeySerializer = SnapshotSerializer<Key>,
+              typename ValueSerializer = SnapshotSerializer<Value>>
+    void loadSnapshot(const string& path, const KeySerializer& ks = KeySerializer(),
+                      const ValueSerializer& vs = ValueSerializer()) {
+        SnapshotReader in(path, kSnapshotMagic);
+        clear();
+        try {
+            restore(in, ks, vs);
+        } catch (...) {
+            clear();
+            throw;
         }
     }
 };
 
-int main() {
+#ifndef NO_MAIN
+// 吞吐测试：80% 请求落在 capacity/2 个热点 key 上，其余均匀分布在 10*capacity 个 key 上，未命中时 put
+void benchmarkLFU(size_t capacity, size_t ops) {
+    LFUCache<uint64_t, uint64_t> cache(capacity);
+    mt19937_64 rng(2024);
+    vector<uint64_t> keys(ops);
+    for (auto& k : keys) {
+        k = (rng() % 10 < 8) ? rng() % (capacity / 2) : capacity + rng() % (10 * capacity);
+    }
+    size_t hits = 0;
+    uint64_t value;
+    auto start = chrono::steady_clock::now();
+    for (uint64_t k : keys) {
+        if (cache.get(k, value)) {
+            hits++;
+        } else {
+            cache.put(k, k);
+        }
+    }
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "capacity=" << capacity << " ops=" << ops << " ops/s=" << static_cast<uint64_t>(ops / secs)
+         << " hit ratio=" << static_cast<double>(hits) / ops << endl;
+}
+
+// 热点漂移：前一半请求集中在热点集合 A，后一半换成集合 B。不衰减时 A 的高计数长期占住缓存
+void benchmarkAging(size_t capacity, size_t ops) {
+    for (uint64_t period : {uint64_t(0), uint64_t(10 * capacity)}) {
+        LFUCache<uint64_t, uint64_t> cache(capacity, period);
+        mt19937_64 rng(7);
+        size_t hits = 0, secondHalfHits = 0;
+        uint64_t value;
+        for (size_t i = 0; i < ops; i++) {
+            uint64_t base = i < ops / 2 ? 0 : 1ull << 32;
+            uint64_t k = (rng() % 10 < 9) ? base + rng() % capacity : (1ull << 40) + rng() % (100 * capacity);
+            if (cache.get(k, value)) {
+                hits++;
+                secondHalfHits += i >= ops / 2;
+            } else {
+                cache.put(k, k);
+            }
+        }
+        cout << "aging period=" << period << " hit ratio=" << static_cast<double>(hits) / ops
+             << " after shift=" << static_cast<double>(secondHalfHits) / (ops - ops / 2) << endl;
+    }
+}
+
+// 快照：capacity 个条目分布在 8 个频次上，写出后读进一个新缓存，对照是重新 put 一遍同样的 key。
+// key 打散过，std::hash 对整数是恒等映射，连续的 key 会让哈希表按顺序访问，测出来偏快
+void benchmarkSnapshot(size_t capacity, const string& path) {
+    auto keyOf = [](uint64_t i) { return i * 0x9E3779B97F4A7C15ull; };
+    {
+        LFUCache<uint64_t, uint64_t> cache(capacity);
+        uint64_t value;
+        for (uint64_t i = 0; i < capacity; i++) {
+            cache.put(keyOf(i), i);
+            for (uint64_t j = 0; j < i % 8; j++) cache.get(keyOf(i), value);
+        }
+        auto start = chrono::steady_clock::now();
+        cache.saveSnapshot(path);
+        double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << "save: " << cache.size() << " entries in " << secs * 1000 << " ms" << endl;
+    }
+    {
+        LFUCache<uint64_t, uint64_t> cache(capacity);
+        auto start = chrono::steady_clock::now();
+        cache.loadSnapshot(path);
+        double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        struct stat st;
+        ::stat(path.c_str(), &st);
+        cout << "load: " << st.st_size / (1 << 20) << " MB, " << cache.size() << " entries in " << secs * 1000
+             << " ms, frequency(key 7)=" << cache.frequency(keyOf(7)) << endl;
+    }
+    {
+        LFUCache<uint64_t, uint64_t> cache(capacity);
+        auto start = chrono::steady_clock::now();
+        for (uint64_t i = 0; i < capacity; i++) cache.put(keyOf(i), i);
+        double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << "refill by put: " << capacity << " entries in " << secs * 1000 << " ms (all counts 1)" << endl;
+    }
+    remove(path.c_str());
+}
+
+// 从标准输入读取 LeetCode 风格的操作序列；带参数 bench 时运行性能测试
+int main(int argc, char** argv) {
+    if (argc > 1 && string(argv[1]) == "bench") {
+        benchmarkLFU(1000000, 10000000);
+        benchmarkAging(100000, 10000000);
+        benchmarkSnapshot(10000000, "/tmp/lfu.snapshot");
+        return 0;
+    }
+
     string op;
-    vector<int> params;
-    LFUCache* cache = nullptr;
-    
+    LFUCache<int, int>* cache = nullptr;
+
     while(cin >> op) {
         if(op == "LFUCache") {
             int capacity;
             cin >> capacity;
-            cache = new LFUCache(capacity);
+            delete cache;
+            cache = new LFUCache<int, int>(capacity);
             cout << "null" << endl;
         }
         else if(op == "put") {
@@ -69,15 +516,16 @@ int main() {
             cout << "null" << endl;
         }
         else if(op == "get") {
-            int key;
+            int key, value;
             cin >> key;
-            cout << cache->get(key) << endl;
+            cout << (cache->get(key, value) ? value : -1) << endl;
         }
     }
-    
+
     delete cache;
     return 0;
 }
+#endif
 
 
 // LFUCache 2
@@ -90,4 +538,4 @@ int main() {
 // put 4 4
 // get 1
 // get 3
-// get 4
\ No newline at end of file
+// get 4
@@ -0,0 +1,351 @@
+#include <iostream>
+#include <iomanip>
+#include <optional>
+#include <unordered_map>
+#include <condition_variable>
+#include <future>
+
+#define NO_MAIN
+#include "ARC.cpp"
+#include "线程池.cpp"
+#undef NO_MAIN
+
+// 自动加载的缓存：未命中时调用 loader 从后端取值，结果带 TTL 放进分片 ARC。
+// 同一个 key 同时只有一次加载在进行（single-flight），其余未命中的线程等待这次加载的结果，
+// 热点 key 过期的瞬间不会有成百上千个请求一起打到后端。加载在 ThreadPool 上执行，
+// 调用 get 的线程只是等待，因此不要在同一个线程池的任务里调用 get，否则池子可能被等待者占满。
+// refreshAhead 不为 0 时，剩余有效期不足 refreshAhead 的命中照常返回旧值，同时在后台提前刷新，
+// 热点 key 就不会真正过期；loader 返回 std::nullopt 表示后端没有这个 key，按 negativeTtl 缓存这个结论
+template <typename Key, typename Value,
+          typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+class LoadingCache {
+public:
+    using Loader = std::function<std::optional<Value>(const Key&)>;
+
+    struct Options {
+        std::chrono::milliseconds ttl{60000};        // 加载到的值的有效期
+        std::chrono::milliseconds negativeTtl{0};    // 不存在的 key 的缓存时间，0 表示不缓存
+        std::chrono::milliseconds refreshAhead{0};   // 到期前多久开始后台刷新，0 表示不刷新
+        size_t shards = 16;
+    };
+
+    struct Stats {
+        uint64_t hits = 0;          // 命中（含负缓存命中）
+        uint64_t negativeHits = 0;  // 命中“不存在”的记录
+        uint64_t misses = 0;        // 发起了加载的未命中
+        uint64_t coalesced = 0;     // 等待别人正在进行的加载的未命中
+        uint64_t loads = 0;         // 调用 loader 的次数（含后台刷新）
+        uint64_t refreshes = 0;     // 后台提前刷新的次数
+        uint64_t failures = 0;      // loader 抛出异常的次数
+    };
+
+private:
+    struct Loaded {
+        std::optional<Value> value;  // std::nullopt 表示后端没有这个 key
+        uint64_t refreshAt = 0;      // 过了这个时刻（ExpiryWheel::now() 的毫秒数）的命中触发后台刷新，0 表示不刷新
+    };
+
+    // 一次正在进行的加载，等待者共享它的结果
+    struct Flight {
+        std::promise<std::optional<Value>> promise;
+        std::shared_future<std::optional<Value>> result;
+    };
+
+    ShardedARCache<Key, Loaded, Hash, KeyEqual> cache;
+    ThreadPool& pool;
+    Loader loader;
+    Options options;
+
+    std::mutex flightMutex;
+    std::condition_variable idle;  // 所有加载结束时通知，析构时等待
+    std::unordered_map<Key, std::shared_ptr<Flight>, Hash, KeyEqual> flights;
+
+    std::atomic<uint64_t> hits{0}, negativeHits{0}, misses{0}, coalesced{0};
+    std::atomic<uint64_t> loads{0}, refreshes{0}, failures{0};
+
+    // 调用方持有 flightMutex：登记一次加载并提交到线程池
+    std::shared_ptr<Flight> startLoad(const Key& key) {
+        auto flight = std::make_shared<Flight>();
+        flight->result = flight->promise.get_future().share();
+        flights.emplace(key, flight);
+        loads++;
+        try {
+            pool.enqueue([this, key, flight] { runLoad(key, *flight); });
+        } catch (...) {
+            flights.erase(key);
+            throw;
+        }
+        return flight;
+    }
+
+    // 在线程池上执行：先写缓存再注销加载，之后到达的请求要么命中缓存，要么还能等到这次加载
+    void runLoad(const Key& key, Flight& flight) {
+        try {
+            std::optional<Value> value = loader(key);
+            store(key, value);
+            finish(key);
+            flight.promise.set_value(std::move(value));
+        } catch (...) {
+            // 失败不缓存，等待者都收到这个异常，下一次未命中重新加载
+            failures++;
+            finish(key);
+            flight.promise.set_exception(std::current_exception());
+        }
+    }
+
+    void store(const Key& key, const std::optional<Value>& value) {
+        if (value) {
+            uint64_t refreshAt = 0;
+            if (options.refreshAhead.count() > 0 && options.refreshAhead < options.ttl) {
+                refreshAt = ExpiryWheel<Key>::now() + (options.ttl - options.refreshAhead).count();
+            }
+            cache.put(key, Loaded{value, refreshAt}, options.ttl);
+        } else if (options.negativeTtl.count() > 0) {
+            cache.put(key, Loaded{std::nullopt, 0}, options.negativeTtl);
+        }
+    }
+
+    void finish(const Key& key) {
+        std::lock_guard<std::mutex> lock(flightMutex);
+        flights.erase(key);
+        if (flights.empty()) idle.notify_all();
+    }
+
+    // 命中时发现快要过期：没有正在进行的加载就在后台刷新一次，不等待结果
+    void refresh(const Key& key) {
+        std::lock_guard<std::mutex> lock(flightMutex);
+        if (flights.count(key) != 0) return;
+        refreshes++;
+        startLoad(key);
+    }
+
+    std::optional<Value> onHit(const Key& key, const Loaded& hit, bool allowRefresh) {
+        hits++;
+        if (!hit.value) negativeHits++;
+        if (allowRefresh && hit.refreshAt != 0 && ExpiryWheel<Key>::now() >= hit.refreshAt) refresh(key);
+        return hit.value;
+    }
+
+public:
+    LoadingCache(size_t capacity, ThreadPool& threadPool, Loader load, Options opts = Options())
+        : cache(capacity, opts.shards), pool(threadPool), loader(std::move(load)), options(opts) {}
+
+    // 等待还在进行的加载结束，线程池里的任务还引用着这个对象
+    ~LoadingCache() {
+        std::unique_lock<std::mutex> lock(flightMutex);
+        idle.wait(lock, [this] { return flights.empty(); });
+    }
+
+    LoadingCache(const LoadingCache&) = delete;
+    LoadingCache& operator=(const LoadingCache&) = delete;
+
+    // 返回 key 的值，后端没有这个 key 时返回 std::nullopt；未命中时阻塞到加载完成，
+    // loader 抛出的异常原样抛给所有等待这次加载的调用方
+    std::optional<Value> get(const Key& key) {
+        Loaded hit;
+        if (cache.get(key, hit)) return onHit(key, hit, true);
+
+        std::shared_future<std::optional<Value>> result;
+        {
+            std::lock_guard<std::mutex> lock(flightMutex);
+            auto it = flights.find(key);
+            if (it != flights.end()) {
+                coalesced++;
+                result = it->second->result;
+            } else if (cache.get(key, hit)) {
+                // 上一次加载在第一次查找之后刚好完成
+                return onHit(key, hit, false);
+            } else {
+                misses++;
+                result = startLoad(key)->result;
+            }
+        }
+        return result.get();
+    }
+
+    // 不触发加载，只查缓存
+    bool getIfPresent(const Key& key, std::optional<Value>& value) {
+        Loaded hit;
+        if (!cache.get(key, hit)) return false;
+        value = onHit(key, hit, true);
+        return true;
+    }
+
+    // 直接写入一个值，按 ttl 过期
+    void put(const Key& key, const Value& value) {
+        store(key, value);
+    }
+
+    Stats stats() const {
+        Stats st;
+        st.hits = hits;
+        st.negativeHits = negativeHits;
+        st.misses = misses;
+        st.coalesced = coalesced;
+        st.loads = loads;
+        st.refreshes = refreshes;
+        st.failures = failures;
+        return st;
+    }
+};
+
+#ifndef NO_MAIN
+// 模拟后端：每次调用耗时 latency，key >= missingFrom 的不存在
+struct FakeBackend {
+    std::chrono::microseconds latency;
+    uint64_t missingFrom;
+    std::atomic<uint64_t> calls{0};
+
+    std::optional<uint64_t> load(uint64_t key) {
+        calls++;
+        std::this_thread::sleep_for(latency);
+        if (key >= missingFrom) return std::nullopt;
+        return key * 2;
+    }
+};
+
+struct LatencySummary {
+    size_t requests = 0;
+    double p50 = 0, p99 = 0, max = 0;  // 微秒
+};
+
+LatencySummary summarize(std::vector<double>& micros) {
+    LatencySummary s;
+    s.requests = micros.size();
+    if (micros.empty()) return s;
+    std::sort(micros.begin(), micros.end());
+    s.p50 = micros[micros.size() / 2];
+    s.p99 = micros[std::min(micros.size() - 1, micros.size() * 99 / 100)];
+    s.max = micros.back();
+    return s;
+}
+
+// threads 个线程同时开始，在 duration 内反复读取 hotKeys 个热点 key，每 pace 一次；
+// missingRatio 的请求落在后端不存在的 key 上。返回所有请求的延迟（微秒）
+template <typename GetFn>
+std::vector<double> runBurst(GetFn&& get, int threads, uint64_t hotKeys, double missingRatio,
+                             std::chrono::milliseconds duration, std::chrono::microseconds pace) {
+    std::vector<std::vector<double>> perThread(threads);
+    std::atomic<int> ready{0};
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            std::mt19937_64 rng(t + 1);
+            ready++;
+            while (ready.load() < threads) std::this_thread::yield();
+            auto end = std::chrono::steady_clock::now() + duration;
+            while (std::chrono::steady_clock::now() < end) {
+                bool missing = std::uniform_real_distribution<double>(0, 1)(rng) < missingRatio;
+                uint64_t key = missing ? (1ull << 40) + rng() % hotKeys : rng() % hotKeys;
+                auto start = std::chrono::steady_clock::now();
+                get(key);
+                perThread[t].push_back(std::chrono::duration<double, std::micro>(
+                    std::chrono::steady_clock::now() - start).count());
+                std::this_thread::sleep_for(pace);
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+    std::vector<double> all;
+    for (auto& v : perThread) all.insert(all.end(), v.begin(), v.end());
+    return all;
+}
+
+void printBurst(const char* name, std::vector<double> micros, uint64_t backendCalls) {
+    LatencySummary s = summarize(micros);
+    std::cout << std::left << std::setw(28) << name << std::right
+              << std::setw(10) << s.requests << std::setw(14) << backendCalls
+              << std::setw(10) << std::fixed << std::setprecision(0) << s.p50
+              << std::setw(10) << s.p99 << std::setw(10) << s.max << std::endl;
+}
+
+// 热点 key 的 TTL 很短，每次过期所有线程同时未命中：
+// 直接包一层 ARC 的写法每个未命中的线程都去后端；single-flight 每个 key 每次过期只加载一次；
+// 再加上提前刷新，热点 key 在过期前就被换成新值，读者基本不再阻塞
+void benchmarkLoadingCache() {
+    const int threads = 64;
+    const uint64_t hotKeys = 16;
+    const auto ttl = std::chrono::milliseconds(50);
+    const auto duration = std::chrono::milliseconds(2000);
+    const auto pace = std::chrono::microseconds(500);
+    const auto latency = std::chrono::microseconds(5000);
+
+    std::cout << threads << " threads, " << hotKeys << " hot keys, ttl=" << ttl.count()
+              << "ms, backend latency=" << latency.count() / 1000 << "ms, 10% requests for missing keys" << std::endl;
+    std::cout << std::left << std::setw(28) << "mode" << std::right << std::setw(10) << "requests"
+              << std::setw(14) << "backend calls" << std::setw(10) << "p50(us)" << std::setw(10) << "p99(us)"
+              << std::setw(10) << "max(us)" << std::endl;
+
+    {
+        // 现有写法：分片 ARC + 未命中时调用方自己查后端再写回，不存在的 key 不缓存
+        FakeBackend backend{latency, 1ull << 40};
+        ShardedARCache<uint64_t, uint64_t> cache(1024);
+        auto micros = runBurst([&](uint64_t key) {
+            uint64_t value;
+            if (cache.get(key, value)) return;
+            std::optional<uint64_t> loaded = backend.load(key);
+            if (loaded) cache.put(key, *loaded, ttl);
+        }, threads, hotKeys, 0.1, duration, pace);
+        printBurst("ARC + direct load", std::move(micros), backend.calls);
+    }
+
+    struct Mode {
+        const char* name;
+        std::chrono::milliseconds negativeTtl;
+        std::chrono::milliseconds refreshAhead;
+    };
+    for (const Mode& mode : {Mode{"single-flight", std::chrono::milliseconds(0), std::chrono::milliseconds(0)},
+                             Mode{"  + negative caching", ttl, std::chrono::milliseconds(0)},
+                             Mode{"  + refresh-ahead 10ms", ttl, std::chrono::milliseconds(10)}}) {
+        FakeBackend backend{latency, 1ull << 40};
+        ThreadPool pool(32);
+        typename LoadingCache<uint64_t, uint64_t>::Options options;
+        options.ttl = ttl;
+        options.negativeTtl = mode.negativeTtl;
+        options.refreshAhead = mode.refreshAhead;
+        LoadingCache<uint64_t, uint64_t> cache(1024, pool, [&](const uint64_t& key) { return backend.load(key); },
+                                               options);
+        auto micros = runBurst([&](uint64_t key) { cache.get(key); }, threads, hotKeys, 0.1, duration, pace);
+        printBurst(mode.name, std::move(micros), backend.calls);
+        auto st = cache.stats();
+        std::cout << "    hits=" << st.hits << " misses=" << st.misses << " coalesced=" << st.coalesced
+                  << " negative hits=" << st.negativeHits << " refreshes=" << st.refreshes << std::endl;
+    }
+}
+
+// 带参数 bench 时运行性能测试
+int main(int argc, char** argv) {
+    if (argc > 1 && std::string(argv[1]) == "bench") {
+        benchmarkLoadingCache();
+        return 0;
+    }
+
+    ThreadPool pool(4);
+    std::atomic<int> calls{0};
+    LoadingCache<std::string, std::string> cache(100, pool, [&](const std::string& key) -> std::optional<std::string> {
+        calls++;
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        if (key == "missing") return std::nullopt;
+        if (key == "broken") throw std::runtime_error("backend unavailable");
+        return "value of " + key;
+    }, {std::chrono::milliseconds(1000), std::chrono::milliseconds(1000), std::chrono::milliseconds(0), 4});
+
+    // 8 个线程同时读同一个冷 key，只加载一次
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 8; i++) {
+        readers.emplace_back([&] { cache.get("hot"); });
+    }
+    for (auto& r : readers) r.join();
+    std::cout << "8 concurrent gets of a cold key -> loader calls: " << calls << std::endl;
+
+    std::cout << "get(missing): " << (cache.get("missing") ? "found" : "not found");
+    std::cout << ", again: " << (cache.get("missing") ? "found" : "not found")
+              << ", loader calls: " << calls << std::endl;
+    try {
+        cache.get("broken");
+    } catch (const std::exception& e) {
+        std::cout << "get(broken) threw: " << e.what() << std::endl;
+    }
+    return 0;
+}
+#endif
@@ -1,91 +1,562 @@
 #include <bits/stdc++.h>
+#include <malloc.h>
+
+#include "expiry-wheel.h"
 
 using namespace std;
+
+// LRU-K：淘汰“倒数第 K 次访问”最早的页面，即后向 K 距离最大的页面。
+// 访问不足 K 次的页面 K 距离视为无穷大，优先淘汰，它们之间按最近一次访问做 LRU；K=1 时退化为 LRU。
+// 相关访问周期 CRP 内的重复访问（例如同一事务里连续读写）只更新 last，不计入历史，
+// 避免短时间突发把冷页面伪装成热页面。
+// 被淘汰页面的历史另外保留（最多 historyCapacity 个，与缓存容量无关），再次访问时接续之前的记录。
+//
+// 存储布局：驻留页面和历史记录共用一张线性探测的开放寻址表，最近 K 次访问时间以环形数组内嵌在槽位里，
+// 历史记录的 LRU 链表用槽位下标串起来；驻留页面另有一个按 K 距离排序的数组二叉堆。
+// 表按 capacity + historyCapacity 一次分配，运行中不再分配内存，删除用回移(backward shift)而不留墓碑。
+// put 可以带 TTL：过期的驻留页面在访问时或由时间轮在 put 中顺带清理时降级为历史记录，访问历史照常保留。
+// 过期时间放在与槽位平行的数组里，第一次使用 TTL 时才分配，不用 TTL 时槽位大小不变
+template <typename Key, typename Value, size_t K = 2,
+          typename Hash = hash<Key>, typename KeyEqual = equal_to<Key>>
 class LRUKCache {
+    static_assert(K >= 1 && K <= 255, "K must be in [1, 255]");
+
 private:
-    int m_capacity;
-    int m_k;
-    int m_timestamp;
-    
-    // 存储缓存的key-value对
-    list<pair<int,int>> cache;  // {key->value}
-    unordered_map<int,list<pair<int,int>>::iterator> cache_map; // {key->iterator}
-    
-    // 存储历史访问记录
-    unordered_map<int, queue<int>> history;  // {key->[timestamps]}
-    list<int> history_list;  // 存储历史记录中的key，按最近访问时间排序
-    unordered_map<int, list<int>::iterator> history_map;  // {key->iterator}
-
-    void updateHistory(int key) {
+    static constexpr uint32_t kNil = UINT32_MAX;
+
+    enum State : uint8_t {
+        Empty = 0,
+        History = 1,   // 只保留访问历史
+        Resident = 2,  // 驻留在缓存中
+    };
+
+    struct Slot {
+        Key key{};
+        Value value{};
+        uint64_t hist[K] = {};  // 最近 K 次非相关访问时间构成的环，hist[head] 为最近一次
+        uint64_t last = 0;      // 最近一次访问（含相关访问）的时间
+        uint32_t hash = 0;      // 混合后哈希的低 32 位，回移时计算理想位置
+        uint32_t prev = kNil;   // History：历史链表前驱；Resident：在堆中的位置
+        uint32_t next = kNil;   // History：历史链表后继
+        uint8_t head = 0;
+        uint8_t refs = 0;       // 已记录的非相关访问次数，最多 K
+        State state = Empty;
+    };
+
+    // 堆中直接存放排序键，比较时不必访问槽位
+    struct HeapItem {
+        uint64_t kth;     // 倒数第 K 次访问时间，不足 K 次为 0
+        uint64_t recent;  // 最近一次非相关访问时间，各页面互不相同
+        uint32_t slot;
+
+        bool operator<(const HeapItem& o) const {
+            return kth != o.kth ? kth < o.kth : recent < o.recent;
+        }
+    };
+
+    size_t m_capacity;
+    uint64_t m_crp;
+    size_t m_historyCapacity;
+    uint64_t m_timestamp = 0;
+
+    vector<Slot> m_slots;
+    size_t m_mask;
+    vector<HeapItem> m_heap;
+    vector<HeapItem> m_skipped;  // 淘汰时暂存处于 CRP 内的堆顶
+    uint32_t m_historyHead = kNil, m_historyTail = kNil;  // head 端为最近访问
+    size_t m_historyCount = 0;
+
+    // 带 TTL 页面的时间轮，每 kExpiryInterval 次 put 推进一次，每次最多检查 kExpiryBudget 条记录
+    static constexpr uint32_t kExpiryInterval = 16;
+    static constexpr size_t kExpiryBudget = 32;
+    ExpiryWheel<Key> m_expiry;
+    vector<uint64_t> m_expireAt;  // 与 m_slots 平行，过期时间（ExpiryWheel::now() 的毫秒数），0 表示不过期
+    uint32_t m_expiryOps = 0;
+    uint64_t m_expired = 0;
+
+    Hash m_hasher;
+    KeyEqual m_keyEqual;
+
+    uint32_t hashOf(const Key& key) const {
+        uint64_t h = static_cast<uint64_t>(m_hasher(key)) * 0x9E3779B97F4A7C15ull;
+        return static_cast<uint32_t>(h >> 32);
+    }
+
+    uint32_t find(const Key& key, uint32_t h) const {
+        for (size_t i = h & m_mask;; i = (i + 1) & m_mask) {
+            const Slot& s = m_slots[i];
+            if (s.state == Empty) return kNil;
+            if (s.hash == h && m_keyEqual(s.key, key)) return static_cast<uint32_t>(i);
+        }
+    }
+
+    HeapItem orderOf(uint32_t i) const {
+        const Slot& s = m_slots[i];
+        return {s.refs >= K ? s.hist[(s.head + 1) % K] : 0, s.hist[s.head], i};
+    }
+
+    // ---- 驻留页面的二叉堆，槽位的 prev 字段记录堆中位置 ----
+    void heapPlace(size_t pos, const HeapItem& item) {
+        m_heap[pos] = item;
+        m_slots[item.slot].prev = static_cast<uint32_t>(pos);
+    }
+
+    void siftUp(size_t pos) {
+        HeapItem item = m_heap[pos];
+        while (pos > 0) {
+            size_t parent = (pos - 1) / 2;
+            if (!(item < m_heap[parent])) break;
+            heapPlace(pos, m_heap[parent]);
+            pos = parent;
+        }
+        heapPlace(pos, item);
+    }
+
+    void siftDown(size_t pos) {
+        HeapItem item = m_heap[pos];
+        size_t n = m_heap.size();
+        while (true) {
+            size_t child = 2 * pos + 1;
+            if (child >= n) break;
+            if (child + 1 < n && m_heap[child + 1] < m_heap[child]) child++;
+            if (!(m_heap[child] < item)) break;
+            heapPlace(pos, m_heap[child]);
+            pos = child;
+        }
+        heapPlace(pos, item);
+    }
+
+    void heapPush(const HeapItem& item) {
+        m_heap.push_back(item);
+        siftUp(m_heap.size() - 1);
+    }
+
+    HeapItem heapPop() {
+        HeapItem top = m_heap.front();
+        m_heap.front() = m_heap.back();
+        m_heap.pop_back();
+        if (!m_heap.empty()) siftDown(0);
+        return top;
+    }
+
+    void heapErase(size_t pos) {
+        HeapItem last = m_heap.back();
+        m_heap.pop_back();
+        if (pos == m_heap.size()) return;
+        heapPlace(pos, last);
+        siftUp(pos);
+        siftDown(m_slots[last.slot].prev);
+    }
+
+    // ---- 历史记录的 LRU 链表 ----
+    void historyPushFront(uint32_t i) {
+        Slot& s = m_slots[i];
+        s.prev = kNil;
+        s.next = m_historyHead;
+        if (m_historyHead != kNil) m_slots[m_historyHead].prev = i; else m_historyTail = i;
+        m_historyHead = i;
+        m_historyCount++;
+    }
+
+    void historyUnlink(uint32_t i) {
+        Slot& s = m_slots[i];
+        if (s.prev != kNil) m_slots[s.prev].next = s.next; else m_historyHead = s.next;
+        if (s.next != kNil) m_slots[s.next].prev = s.prev; else m_historyTail = s.prev;
+        m_historyCount--;
+    }
+
+    // 把槽位 from 挪到空槽位 to，同时修正堆或历史链表里指向它的下标
+    void moveSlot(uint32_t from, uint32_t to) {
+        m_slots[to] = std::move(m_slots[from]);
+        if (!m_expireAt.empty()) m_expireAt[to] = m_expireAt[from];
+        Slot& s = m_slots[to];
+        if (s.state == Resident) {
+            m_heap[s.prev].slot = to;
+        } else {
+            if (s.prev != kNil) m_slots[s.prev].next = to; else m_historyHead = to;
+            if (s.next != kNil) m_slots[s.next].prev = to; else m_historyTail = to;
+        }
+    }
+
+    // 回移删除：把后面探测链上能前移的槽位依次前移，表中不留墓碑
+    void eraseSlot(uint32_t i) {
+        for (uint32_t j = i;;) {
+            j = static_cast<uint32_t>((j + 1) & m_mask);
+            if (m_slots[j].state == Empty) break;
+            uint32_t home = static_cast<uint32_t>(m_slots[j].hash & m_mask);
+            if (((j - home) & m_mask) >= ((j - i) & m_mask)) {
+                moveSlot(j, i);
+                i = j;
+            }
+        }
+        m_slots[i] = Slot();
+        setDeadline(i, 0);
+    }
+
+    // 记录一次访问：相关访问只更新 last；非相关访问先把上一段相关周期的长度
+    // 加到旧的历史上（相关周期内的访问视为一次），再把当前时间压入环
+    void reference(Slot& s) {
+        uint64_t now = m_timestamp;
+        if (s.refs > 0 && now - s.last <= m_crp) {
+            s.last = now;
+            return;
+        }
+        if (s.refs > 0) {
+            uint64_t correl = s.last - s.hist[s.head];
+            for (size_t i = 0; correl != 0 && i < s.refs; i++) {
+                s.hist[(s.head + K - i) % K] += correl;
+            }
+        }
+        s.head = static_cast<uint8_t>((s.head + 1) % K);
+        s.hist[s.head] = now;
+        s.last = now;
+        if (s.refs < K) s.refs++;
+    }
+
+    // 访问 key 并返回它的槽位；sameAccess 为 true 且上一次操作刚访问过它时（get 未命中后紧接着 put）不重复计数
+    uint32_t access(const Key& key, bool sameAccess) {
+        uint32_t h = hashOf(key);
+        uint32_t i = find(key, h);
+        if (i == kNil) {
+            i = static_cast<uint32_t>(h & m_mask);
+            while (m_slots[i].state != Empty) i = static_cast<uint32_t>((i + 1) & m_mask);
+            Slot& s = m_slots[i];
+            s.key = key;
+            s.hash = h;
+            s.state = History;
+            historyPushFront(i);
+        }
+        Slot& s = m_slots[i];
+        if (sameAccess && s.refs > 0 && s.last == m_timestamp) {
+            return i;
+        }
         m_timestamp++;
-        
-        // 更新访问历史
-        if (!history.count(key)) {
-            history[key] = queue<int>();
-            history_list.push_front(key);
-            history_map[key] = history_list.begin();
+        reference(s);
+        if (s.state == Resident) {
+            // 访问只会让排序键变大，下沉即可
+            HeapItem& item = m_heap[s.prev];
+            item.kth = s.refs >= K ? s.hist[(s.head + 1) % K] : 0;
+            item.recent = s.hist[s.head];
+            siftDown(s.prev);
+        } else if (m_historyHead != i) {
+            historyUnlink(i);
+            historyPushFront(i);
+        }
+        return i;
+    }
+
+    // 淘汰后向 K 距离最大、且不在相关访问周期内的页面；全部处于相关周期时退回到 K 距离最大者
+    void evict() {
+        while (!m_heap.empty() && m_timestamp - m_slots[m_heap.front().slot].last <= m_crp) {
+            m_skipped.push_back(heapPop());
+        }
+        uint32_t victim;
+        if (!m_heap.empty()) {
+            victim = heapPop().slot;
+            for (const HeapItem& item : m_skipped) heapPush(item);
         } else {
-            history_list.erase(history_map[key]);
-            history_list.push_front(key);
-            history_map[key] = history_list.begin();
+            victim = m_skipped.front().slot;
+            for (size_t i = 1; i < m_skipped.size(); i++) heapPush(m_skipped[i]);
         }
-        
-        auto& q = history[key];
-        q.push(m_timestamp);
-        if (q.size() > m_k) {
-            q.pop();
+        m_skipped.clear();
+
+        demote(victim);
+    }
+
+    // 驻留页面降级为历史记录，值随之释放
+    void demote(uint32_t i) {
+        Slot& s = m_slots[i];
+        s.state = History;
+        s.value = Value{};
+        setDeadline(i, 0);
+        historyPushFront(i);
+    }
+
+    uint64_t deadlineOf(uint32_t i) const {
+        return m_expireAt.empty() ? 0 : m_expireAt[i];
+    }
+
+    void setDeadline(uint32_t i, uint64_t deadline) {
+        if (m_expireAt.empty()) {
+            if (deadline == 0) return;
+            m_expireAt.assign(m_slots.size(), 0);
         }
-        
-        // 如果历史记录超过容量，删除最久未访问的记录
-        while (history.size() > m_capacity) {
-            int remove_key = history_list.back();
-            history_list.pop_back();
-            history.erase(remove_key);
-            history_map.erase(remove_key);
+        m_expireAt[i] = deadline;
+    }
+
+    bool isExpired(uint32_t i) const {
+        uint64_t deadline = deadlineOf(i);
+        return deadline != 0 && deadline <= ExpiryWheel<Key>::now();
+    }
+
+    // 过期的驻留页面移出堆，降级为历史记录；不在这里清理历史，调用方最后统一 trimHistory。
+    // 过期处理都是冷路径，不内联进 get/put
+    __attribute__((noinline)) void expireSlot(uint32_t i) {
+        m_expired++;
+        heapErase(m_slots[i].prev);
+        demote(i);
+    }
+
+    __attribute__((noinline)) void expireIfDue(uint32_t i) {
+        if (isExpired(i)) expireSlot(i);
+    }
+
+    // 时间轮里的记录仍对应当前驻留页面（没有被更新、淘汰或提前过期）时返回槽位
+    uint32_t liveSlot(const Key& key, uint64_t deadline) const {
+        uint32_t i = find(key, hashOf(key));
+        return i != kNil && m_slots[i].state == Resident && deadlineOf(i) == deadline ? i : kNil;
+    }
+
+    __attribute__((noinline)) void advanceExpiry(size_t budget) {
+        m_expiry.advance(ExpiryWheel<Key>::now(), budget, [this](const Key& key, uint64_t deadline) {
+            uint32_t i = liveSlot(key, deadline);
+            if (i != kNil) expireSlot(i);
+        });
+    }
+
+    void maintainExpiry() {
+        if (m_expiry.empty() || ++m_expiryOps < kExpiryInterval) return;
+        m_expiryOps = 0;
+        advanceExpiry(kExpiryBudget);
+    }
+
+    void store(const Key& key, const Value& value, uint64_t deadline) {
+        if (m_capacity == 0) return;
+
+        uint32_t i = access(key, true);
+        Slot& s = m_slots[i];
+        if (s.state == Resident) {
+            s.value = value;
+            setDeadline(i, deadline);
+            return;
         }
+
+        historyUnlink(i);
+        if (m_heap.size() == m_capacity) evict();
+        s.state = Resident;
+        s.value = value;
+        setDeadline(i, deadline);
+        heapPush(orderOf(i));
+        // 最后再清理历史：回移可能挪动槽位 i
+        trimHistory();
     }
 
-    bool isKAccessed(int key) {
-        return history[key].size() >= m_k;
+    // 历史超出上限时丢弃最久未访问的记录
+    void trimHistory() {
+        while (m_historyCount > m_historyCapacity) {
+            uint32_t oldest = m_historyTail;
+            historyUnlink(oldest);
+            eraseSlot(oldest);
+        }
     }
 
 public:
-    LRUKCache(int capacity, int k) : m_capacity(capacity), m_k(k), m_timestamp(0) {}
-    
-    int get(int key) {
-        updateHistory(key);
-        
-        if (!cache_map.count(key)) return -1;
-        
-        // 如果在缓存中，更新位置
-        cache.splice(cache.begin(), cache, cache_map[key]);
-        return cache_map[key]->second;
-    }
-    
-    void put(int key, int value) {
-        updateHistory(key);
-        
-        // 如果key已经在缓存中
-        if (cache_map.count(key)) {
-            cache_map[key]->second = value;
-            cache.splice(cache.begin(), cache, cache_map[key]);
-            return;
+    // crp 以访问次数计，0 表示每次访问都是非相关的；historyCapacity 为 0 时取 capacity
+    LRUKCache(size_t capacity, uint64_t crp = 0, size_t historyCapacity = 0)
+        : m_capacity(capacity),
+          m_crp(crp),
+          m_historyCapacity(historyCapacity == 0 ? max<size_t>(capacity, 1) : historyCapacity) {
+        // 同时存在的条目最多 capacity + historyCapacity + 1 个（新 key 进入时短暂多出一个），
+        // 装载因子不超过 3/4
+        size_t tracked = m_capacity + m_historyCapacity + 1;
+        size_t n = 16;
+        while (n < tracked + tracked / 3 + 1) n <<= 1;
+        if (n > kNil) throw length_error("LRUKCache too large");
+        m_slots.resize(n);
+        m_mask = n - 1;
+        m_heap.reserve(m_capacity);
+    }
+
+    LRUKCache(const LRUKCache&) = delete;
+    LRUKCache& operator=(const LRUKCache&) = delete;
+
+    // 获取缓存值，命中返回 true；命中与否都记为一次访问
+    bool get(const Key& key, Value& value) {
+        uint32_t i = access(key, false);
+        if (m_slots[i].state == Resident && !m_expireAt.empty()) expireIfDue(i);
+        bool hit = m_slots[i].state == Resident;
+        if (hit) value = m_slots[i].value;
+        trimHistory();
+        return hit;
+    }
+
+    // 获取缓存值，如果不存在返回默认构造的值
+    Value get(const Key& key) {
+        Value value{};
+        get(key, value);
+        return value;
+    }
+
+    // 设置或更新缓存值，不过期；覆盖带 TTL 的旧值时取消它的过期时间
+    void put(const Key& key, const Value& value) {
+        maintainExpiry();
+        store(key, value, 0);
+    }
+
+    // 设置或更新缓存值，ttl 之后过期
+    void put(const Key& key, const Value& value, chrono::milliseconds ttl) {
+        maintainExpiry();
+        if (m_capacity == 0) return;
+        // 截止时间 0 保留给“不过期”；ttl 不大于 0 时下次访问即过期
+        uint64_t deadline = max<uint64_t>(ExpiryWheel<Key>::now() + max<int64_t>(ttl.count(), 0), 1);
+        store(key, value, deadline);
+        m_expiry.schedule(key, deadline);
+        // 被更新、淘汰的页面在时间轮里留下旧记录，超过驻留页面两倍时清理一次
+        if (m_expiry.size() > 2 * m_heap.size() + 1024) {
+            m_expiry.compact([this](const Key& k, uint64_t d) { return liveSlot(k, d) != kNil; });
         }
-        
-        // 只有当访问次数达到K次时才放入缓存
-        if (!isKAccessed(key)) {
-            return;
+    }
+
+    // 立即把已经过期的页面降级为历史记录，返回处理的个数；精度为时间轮的一个 tick
+    size_t removeExpired() {
+        uint64_t before = m_expired;
+        advanceExpiry(SIZE_MAX);
+        trimHistory();
+        return static_cast<size_t>(m_expired - before);
+    }
+
+    bool contains(const Key& key) const {
+        uint32_t i = find(key, hashOf(key));
+        return i != kNil && m_slots[i].state == Resident && !isExpired(i);
+    }
+
+    // 包含已过期但还没被清理的页面
+    size_t size() const {
+        return m_heap.size();
+    }
+
+    // 被跟踪的 key 总数（驻留 + 只保留历史）
+    size_t trackedKeys() const {
+        return m_heap.size() + m_historyCount;
+    }
+
+    // 因 TTL 到期被降级的页面数
+    uint64_t expiredCount() const {
+        return m_expired;
+    }
+};
+
+#ifndef NO_MAIN
+// 热点数据 + 周期性顺序扫描：80% 请求落在 capacity/2 个热点 key 上，其余均匀分布在 10*capacity 个冷 key 上，
+// 每 10*capacity 次请求插入一次 2*capacity 个新 key 的扫描。get 未命中后 put
+template <typename Cache>
+void replayScanTrace(const char* name, Cache& cache, size_t capacity, size_t ops) {
+    mt19937_64 rng(42);
+    uint64_t scanKey = 1ull << 40;
+    size_t hits = 0, hotHits = 0, hotOps = 0;
+    uint64_t value;
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < ops;) {
+        if (i % (10 * capacity) == 0 && i > 0) {
+            for (size_t j = 0; j < 2 * capacity && i < ops; j++, i++) {
+                if (!cache.get(scanKey, value)) cache.put(scanKey, scanKey);
+                scanKey++;
+            }
+            continue;
+        }
+        bool hot = rng() % 10 < 8;
+        uint64_t k = hot ? rng() % (capacity / 2) : capacity + rng() % (10 * capacity);
+        if (cache.get(k, value)) {
+            hits++;
+            hotHits += hot;
+        } else {
+            cache.put(k, k);
         }
-        
-        // 如果缓存满了，删除最久未使用的元素
-        if (cache.size() == m_capacity) {
-            int remove_key = cache.back().first;
-            cache_map.erase(remove_key);
-            cache.pop_back();
+        hotOps += hot;
+        i++;
+    }
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << name << ": hit ratio=" << static_cast<double>(hits) / ops
+         << " hot-key hit ratio=" << static_cast<double>(hotHits) / hotOps
+         << " ops/s=" << static_cast<uint64_t>(ops / secs) << endl;
+}
+
+void benchmarkLRUK(size_t capacity, size_t ops) {
+    cout << "capacity=" << capacity << " ops=" << ops << " (hot set + periodic scans)" << endl;
+    {
+        LRUKCache<uint64_t, uint64_t, 1> lru(capacity);
+        replayScanTrace("  K=1 (LRU)     ", lru, capacity, ops);
+    }
+    {
+        LRUKCache<uint64_t, uint64_t, 2> lru2(capacity);
+        replayScanTrace("  K=2           ", lru2, capacity, ops);
+    }
+    {
+        LRUKCache<uint64_t, uint64_t, 2> lru2crp(capacity, 16);
+        replayScanTrace("  K=2, CRP=16   ", lru2crp, capacity, ops);
+    }
+    {
+        LRUKCache<uint64_t, uint64_t, 3> lru3(capacity);
+        replayScanTrace("  K=3           ", lru3, capacity, ops);
+    }
+}
+
+// 内存占用：先用大量不同的 key 把驻留区和历史区都填满，再按热点分布访问，统计每个被跟踪 key 的堆字节数
+// 大块内存由 mmap 分配，计入 hblkhd 而不是 uordblks
+size_t heapBytes() {
+    struct mallinfo2 mi = mallinfo2();
+    return mi.uordblks + mi.hblkhd;
+}
+
+void benchmarkLRUKMemory(size_t capacity, size_t historyCapacity, size_t ops) {
+    size_t before = heapBytes();
+    {
+        LRUKCache<uint64_t, uint64_t, 2> cache(capacity, 0, historyCapacity);
+        uint64_t value;
+        for (uint64_t k = 0; k < 2 * (capacity + historyCapacity); k++) {
+            if (!cache.get(k, value)) cache.put(k, k);
+        }
+        size_t bytes = heapBytes() - before;
+        mt19937_64 rng(7);
+        size_t hits = 0;
+        auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < ops; i++) {
+            uint64_t k = rng() % 10 < 8 ? rng() % capacity : rng() % (20 * capacity);
+            if (cache.get(k, value)) {
+                hits++;
+            } else {
+                cache.put(k, k);
+            }
         }
-        
-        // 放入缓存
-        cache.push_front({key, value});
-        cache_map[key] = cache.begin();
+        double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << "capacity=" << capacity << " history=" << historyCapacity
+             << " tracked=" << cache.trackedKeys() << " bytes/key=" << bytes / cache.trackedKeys()
+             << " ops/s=" << static_cast<uint64_t>(ops / secs)
+             << " hit ratio=" << static_cast<double>(hits) / ops << endl;
+    }
+}
+
+// 带参数 bench 时运行性能测试
+int main(int argc, char** argv) {
+    if (argc > 1 && string(argv[1]) == "bench") {
+        benchmarkLRUK(100000, 10000000);
+        benchmarkLRUKMemory(1000000, 1000000, 10000000);
+        benchmarkLRUKMemory(1000000, 4000000, 10000000);
+        return 0;
+    }
+
+    LRUKCache<string, string, 2> cache(2);
+    cache.put("a", "1");
+    cache.get("a");                  // a 访问两次
+    cache.put("b", "2");             // b 访问一次，K 距离无穷大
+    cache.put("c", "3");             // 淘汰 b 而不是更早写入的 a
+    cout << "contains a: " << cache.contains("a") << ", b: " << cache.contains("b")
+         << ", c: " << cache.contains("c") << endl;
+
+    // 相关访问：d 的三次访问彼此相邻，落在 CRP 内只计一次，仍先于真正访问过两次的 e 被淘汰；
+    // crp=0 时 d 会被当作访问过三次，淘汰的就是 e
+    for (uint64_t period : {1, 0}) {
+        LRUKCache<string, string, 2> crp(2, period);
+        crp.put("e", "1");
+        crp.put("x", "0");
+        crp.get("e");
+        crp.put("d", "1");
+        crp.get("d");
+        crp.get("d");
+        crp.get("z");
+        crp.put("f", "1");
+        cout << "crp=" << period << " contains e: " << crp.contains("e") << ", d: " << crp.contains("d") << endl;
     }
-};
\ No newline at end of file
+    return 0;
+}
+#endif
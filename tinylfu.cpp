@@ -0,0 +1,440 @@
+#include <bits/stdc++.h>
+#include <malloc.h>
+using namespace std;
+
+// 4 位 count-min sketch：4 行，每行宽度为不小于 4 倍容量的 2 的幂，16 个计数器打包在一个 uint64_t 里，
+// 每个缓存条目约 8 字节（行宽只取容量大小时冲突明显，Zipf 0.8 下命中率低约 3 个百分点）。
+// 计数到 15 饱和；累计 sampleSize 次递增后所有计数器减半（reset），让频率估计反映最近一段时间的热度
+class FrequencySketch {
+private:
+    vector<uint64_t> m_table;
+    size_t m_width;     // 每行计数器个数
+    size_t m_rowWords;  // 每行占用的 uint64_t 个数
+    size_t m_sampleSize;
+    size_t m_additions = 0;
+
+    // 第 row 行计数器在 m_table 中的字下标与位偏移，行间用双重哈希
+    pair<size_t, unsigned> locate(uint64_t h, unsigned row) const {
+        uint32_t h1 = static_cast<uint32_t>(h), h2 = static_cast<uint32_t>(h >> 32) | 1;
+        size_t idx = (h1 + row * h2) & (m_width - 1);
+        return {row * m_rowWords + idx / 16, static_cast<unsigned>(idx % 16) * 4};
+    }
+
+    void reset() {
+        for (uint64_t& w : m_table) w = (w >> 1) & 0x7777777777777777ull;
+        m_additions /= 2;
+    }
+
+public:
+    explicit FrequencySketch(size_t capacity) {
+        m_width = 16;
+        while (m_width < 4 * capacity) m_width <<= 1;
+        m_rowWords = m_width / 16;
+        m_table.assign(4 * m_rowWords, 0);
+        m_sampleSize = 10 * max<size_t>(capacity, 1);
+    }
+
+    // 递增 h 对应的计数器；发生 reset 时返回 true
+    bool increment(uint64_t h) {
+        bool added = false;
+        for (unsigned row = 0; row < 4; row++) {
+            auto [word, shift] = locate(h, row);
+            if (((m_table[word] >> shift) & 0xF) < 0xF) {
+                m_table[word] += 1ull << shift;
+                added = true;
+            }
+        }
+        if (added && ++m_additions >= m_sampleSize) {
+            reset();
+            return true;
+        }
+        return false;
+    }
+
+    unsigned estimate(uint64_t h) const {
+        unsigned freq = 0xF;
+        for (unsigned row = 0; row < 4; row++) {
+            auto [word, shift] = locate(h, row);
+            freq = min(freq, static_cast<unsigned>((m_table[word] >> shift) & 0xF));
+        }
+        return freq;
+    }
+
+    size_t bytes() const {
+        return m_table.size() * sizeof(uint64_t);
+    }
+};
+
+// 门卫(doorkeeper)：一个周期内第一次出现的 key 只记在这个布隆过滤器里，第二次出现才进入 sketch，
+// 大量只访问一次的 key 因此不会挤占 sketch 的计数器。随 sketch 的 reset 一起清空
+class Doorkeeper {
+private:
+    vector<uint64_t> m_bits;
+    size_t m_mask;
+
+public:
+    explicit Doorkeeper(size_t expectedInsertions) {
+        size_t n = 64;
+        while (n < 4 * expectedInsertions) n <<= 1;
+        m_bits.assign(n / 64, 0);
+        m_mask = n - 1;
+    }
+
+    bool contains(uint64_t h) const {
+        size_t a = h & m_mask, b = (h >> 32) & m_mask;
+        return (m_bits[a / 64] >> (a % 64) & 1) && (m_bits[b / 64] >> (b % 64) & 1);
+    }
+
+    // 加入 h，返回加入前是否已经存在
+    bool put(uint64_t h) {
+        size_t a = h & m_mask, b = (h >> 32) & m_mask;
+        bool present = (m_bits[a / 64] >> (a % 64) & 1) && (m_bits[b / 64] >> (b % 64) & 1);
+        m_bits[a / 64] |= 1ull << (a % 64);
+        m_bits[b / 64] |= 1ull << (b % 64);
+        return present;
+    }
+
+    void clear() {
+        fill(m_bits.begin(), m_bits.end(), 0);
+    }
+
+    size_t bytes() const {
+        return m_bits.size() * sizeof(uint64_t);
+    }
+};
+
+// W-TinyLFU：新 key 先进入占容量 1% 的窗口 LRU；窗口溢出时，被挤出的候选者与主区的淘汰者比较
+// sketch 估计的访问频率，频率更高者留下。主区是分段 LRU：第一次进入放在试用段(probation)，
+// 在试用段命中后升入保护段(protected，占主区 80%)，保护段溢出时最旧的退回试用段头部。
+// 窗口让突发的新 key 有机会积累频率，准入过滤挡住只访问一次的 key
+template <typename Key, typename Value, typename Hash = hash<Key>, typename KeyEqual = equal_to<Key>>
+class TinyLFUCache {
+public:
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t admitted = 0;  // 候选者胜出进入主区
+        uint64_t rejected = 0;  // 候选者被准入过滤丢弃
+        size_t window = 0, probation = 0, protectedSize = 0;
+    };
+
+private:
+    enum Segment : uint8_t {
+        Window = 0,
+        Probation = 1,
+        Protected = 2,
+    };
+
+    struct Links {
+        Links* prev;
+        Links* next;
+    };
+
+    struct Entry : Links {
+        Key key;
+        Value value;
+        uint64_t hash;
+        Segment segment;
+
+        Entry(const Key& k, const Value& v, uint64_t h) : key(k), value(v), hash(h), segment(Window) {}
+    };
+
+    size_t m_capacity;
+    size_t m_windowCapacity;
+    size_t m_mainCapacity;
+    size_t m_protectedCapacity;
+
+    // 三个段的哨兵，next 一端为 MRU，prev 一端为 LRU
+    Links m_lists[3];
+    size_t m_sizes[3] = {0, 0, 0};
+
+    unordered_map<Key, Entry*, Hash, KeyEqual> m_entries;
+    Hash m_hasher;
+    FrequencySketch m_sketch;
+    Doorkeeper m_doorkeeper;
+    uint64_t m_lastMiss = 0;  // 最近一次 get 未命中的 key 的哈希，紧随其后的 put 不重复计数
+
+    uint64_t m_hits = 0, m_misses = 0, m_admitted = 0, m_rejected = 0;
+
+    uint64_t hashOf(const Key& key) const {
+        uint64_t h = static_cast<uint64_t>(m_hasher(key)) * 0x9E3779B97F4A7C15ull;
+        return (h ^ (h >> 29)) | 1;
+    }
+
+    void unlink(Entry* e) {
+        e->prev->next = e->next;
+        e->next->prev = e->prev;
+        m_sizes[e->segment]--;
+    }
+
+    void pushFront(Entry* e, Segment segment) {
+        Links& head = m_lists[segment];
+        e->prev = &head;
+        e->next = head.next;
+        head.next->prev = e;
+        head.next = e;
+        e->segment = segment;
+        m_sizes[segment]++;
+    }
+
+    void moveToFront(Entry* e, Segment segment) {
+        unlink(e);
+        pushFront(e, segment);
+    }
+
+    Entry* back(Segment segment) {
+        return static_cast<Entry*>(m_lists[segment].prev);
+    }
+
+    void destroy(Entry* e) {
+        unlink(e);
+        m_entries.erase(e->key);
+        delete e;
+    }
+
+    // 记录一次访问：周期内第一次出现只进门卫，之后进 sketch
+    void record(uint64_t h) {
+        if (!m_doorkeeper.put(h)) return;
+        if (m_sketch.increment(h)) m_doorkeeper.clear();
+    }
+
+    unsigned frequency(uint64_t h) const {
+        return m_sketch.estimate(h) + (m_doorkeeper.contains(h) ? 1 : 0);
+    }
+
+    void onHit(Entry* e) {
+        switch (e->segment) {
+        case Window:
+        case Protected:
+            moveToFront(e, e->segment);
+            break;
+        case Probation:
+            moveToFront(e, Protected);
+            if (m_sizes[Protected] > m_protectedCapacity) {
+                moveToFront(back(Protected), Probation);
+            }
+            break;
+        }
+    }
+
+    // 窗口溢出：最旧的窗口条目作为候选者进入主区，主区满时与试用段最旧的条目比较频率
+    void evictFromWindow() {
+        Entry* candidate = back(Window);
+        if (m_sizes[Probation] + m_sizes[Protected] < m_mainCapacity) {
+            moveToFront(candidate, Probation);
+            return;
+        }
+        if (m_mainCapacity == 0) {
+            destroy(candidate);
+            return;
+        }
+        Entry* victim = m_sizes[Probation] > 0 ? back(Probation) : back(Protected);
+        if (frequency(candidate->hash) > frequency(victim->hash)) {
+            m_admitted++;
+            destroy(victim);
+            moveToFront(candidate, Probation);
+        } else {
+            m_rejected++;
+            destroy(candidate);
+        }
+    }
+
+public:
+    TinyLFUCache(size_t capacity)
+        : m_capacity(capacity),
+          m_windowCapacity(max<size_t>(capacity / 100, 1)),
+          m_mainCapacity(capacity > m_windowCapacity ? capacity - m_windowCapacity : 0),
+          m_protectedCapacity(m_mainCapacity * 8 / 10),
+          m_sketch(capacity),
+          m_doorkeeper(4 * capacity) {
+        for (auto& l : m_lists) {
+            l.prev = l.next = &l;
+        }
+        m_entries.reserve(capacity + 1);
+    }
+
+    ~TinyLFUCache() {
+        for (auto& kv : m_entries) delete kv.second;
+    }
+
+    TinyLFUCache(const TinyLFUCache&) = delete;
+    TinyLFUCache& operator=(const TinyLFUCache&) = delete;
+
+    // 获取缓存值，命中返回 true；命中与否都记为一次访问
+    bool get(const Key& key, Value& value) {
+        uint64_t h = hashOf(key);
+        record(h);
+        auto it = m_entries.find(key);
+        if (it == m_entries.end()) {
+            m_misses++;
+            m_lastMiss = h;
+            return false;
+        }
+        m_hits++;
+        m_lastMiss = 0;
+        onHit(it->second);
+        value = it->second->value;
+        return true;
+    }
+
+    // 获取缓存值，如果不存在返回默认构造的值
+    Value get(const Key& key) {
+        Value value{};
+        get(key, value);
+        return value;
+    }
+
+    void put(const Key& key, const Value& value) {
+        if (m_capacity == 0) return;
+
+        uint64_t h = hashOf(key);
+        if (h != m_lastMiss) record(h);
+        m_lastMiss = 0;
+
+        auto it = m_entries.find(key);
+        if (it != m_entries.end()) {
+            it->second->value = value;
+            onHit(it->second);
+            return;
+        }
+
+        Entry* e = new Entry(key, value, h);
+        m_entries.emplace(key, e);
+        pushFront(e, Window);
+        if (m_sizes[Window] > m_windowCapacity) evictFromWindow();
+    }
+
+    bool contains(const Key& key) const {
+        return m_entries.count(key) != 0;
+    }
+
+    size_t size() const {
+        return m_entries.size();
+    }
+
+    // sketch 与门卫占用的字节数
+    size_t filterBytes() const {
+        return m_sketch.bytes() + m_doorkeeper.bytes();
+    }
+
+    Stats stats() const {
+        Stats st;
+        st.hits = m_hits;
+        st.misses = m_misses;
+        st.admitted = m_admitted;
+        st.rejected = m_rejected;
+        st.window = m_sizes[Window];
+        st.probation = m_sizes[Probation];
+        st.protectedSize = m_sizes[Protected];
+        return st;
+    }
+};
+
+#ifndef NO_MAIN
+#define NO_MAIN
+#include "ARC.cpp"
+#include "lfu.cpp"
+#include "lru-k.cpp"
+#undef NO_MAIN
+
+// 按 Zipf(alpha) 分布生成 [0, n) 的访问序列，key 编号打乱，避免热点恰好是连续整数
+vector<uint64_t> zipfKeys(size_t n, double alpha, size_t length, uint64_t seed) {
+    vector<double> cdf(n);
+    double sum = 0;
+    for (size_t i = 0; i < n; i++) {
+        sum += 1.0 / pow(static_cast<double>(i + 1), alpha);
+        cdf[i] = sum;
+    }
+    mt19937_64 rng(seed);
+    uniform_real_distribution<double> dist(0, sum);
+    vector<uint64_t> perm(n);
+    iota(perm.begin(), perm.end(), 0);
+    shuffle(perm.begin(), perm.end(), rng);
+    vector<uint64_t> trace(length);
+    for (auto& t : trace) {
+        t = perm[lower_bound(cdf.begin(), cdf.end(), dist(rng)) - cdf.begin()];
+    }
+    return trace;
+}
+
+size_t mallocBytes() {
+    struct mallinfo2 mi = mallinfo2();
+    return mi.uordblks + mi.hblkhd;
+}
+
+template <typename Cache>
+void replayPolicy(const char* name, const vector<uint64_t>& trace, size_t capacity) {
+    size_t before = mallocBytes();
+    Cache cache(capacity);
+    size_t hits = 0;
+    uint64_t value;
+    auto start = chrono::steady_clock::now();
+    for (uint64_t k : trace) {
+        if (cache.get(k, value)) {
+            hits++;
+        } else {
+            cache.put(k, k);
+        }
+    }
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << name << ": hit ratio=" << fixed << setprecision(4) << static_cast<double>(hits) / trace.size()
+         << " ops/s=" << static_cast<uint64_t>(trace.size() / secs)
+         << " heap=" << (mallocBytes() - before) / (1 << 20) << "MB" << defaultfloat << endl;
+}
+
+void benchmarkPolicies() {
+    const size_t universe = 1000000, capacity = 100000, length = 5000000;
+    vector<pair<string, vector<uint64_t>>> traces;
+    traces.emplace_back("zipf 0.8", zipfKeys(universe, 0.8, length, 7));
+    traces.emplace_back("zipf 1.0", zipfKeys(universe, 1.0, length, 7));
+    // zipf 0.9 中每 50 万次请求插入一段 20 万个从未出现过的 key 的扫描（只访问一次的 key）
+    vector<uint64_t> scan = zipfKeys(universe, 0.9, length, 7);
+    uint64_t fresh = universe;
+    for (size_t i = 0; i + 200000 <= scan.size(); i += 500000) {
+        for (size_t j = 0; j < 200000; j++) scan[i + j] = fresh++;
+    }
+    traces.emplace_back("zipf 0.9 + scans", move(scan));
+    // 循环访问 1.25 倍容量的 key，LRU 在这种模式下完全失效
+    vector<uint64_t> loop(length);
+    for (size_t i = 0; i < length; i++) loop[i] = i % (capacity + capacity / 4);
+    traces.emplace_back("loop 1.25x", move(loop));
+
+    for (auto& [name, trace] : traces) {
+        cout << name << ", capacity=" << capacity << endl;
+        replayPolicy<LRUKCache<uint64_t, uint64_t, 1>>("  LRU      ", trace, capacity);
+        replayPolicy<LRUKCache<uint64_t, uint64_t, 2>>("  LRU-2    ", trace, capacity);
+        replayPolicy<LFUCache<uint64_t, uint64_t>>("  LFU      ", trace, capacity);
+        replayPolicy<ARCache<uint64_t, uint64_t>>("  ARC      ", trace, capacity);
+        replayPolicy<TinyLFUCache<uint64_t, uint64_t>>("  W-TinyLFU", trace, capacity);
+    }
+}
+
+// 带参数 bench 时运行性能测试
+int main(int argc, char** argv) {
+    if (argc > 1 && string(argv[1]) == "bench") {
+        benchmarkPolicies();
+        return 0;
+    }
+
+    TinyLFUCache<string, string> cache(100);
+    string value;
+    // 热点 key 访问多次，积累频率
+    for (int round = 0; round < 5; round++) {
+        for (int i = 0; i < 80; i++) {
+            string k = "hot" + to_string(i);
+            if (!cache.get(k, value)) cache.put(k, k);
+        }
+    }
+    // 一次性扫描：只访问一次的 key 会被准入过滤挡在主区之外
+    for (int i = 0; i < 1000; i++) {
+        string k = "scan" + to_string(i);
+        if (!cache.get(k, value)) cache.put(k, k);
+    }
+    int hot = 0;
+    for (int i = 0; i < 80; i++) hot += cache.contains("hot" + to_string(i));
+    auto st = cache.stats();
+    cout << "hot keys still cached: " << hot << "/80, admitted=" << st.admitted << " rejected=" << st.rejected
+         << ", sketch+doorkeeper=" << cache.filterBytes() << " bytes" << endl;
+    return 0;
+}
+#endif
@@ -6,21 +6,164 @@
 #include <functional>
 #include <cstdlib>
 #include <sstream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <stdexcept>
+#include <string_view>
+
+// 冻结的哈希环：虚拟节点的哈希值排好序后按 Eytzinger（BFS）顺序放进一个连续数组，owners 是并行的节点下标。
+// 第 k 个元素的两个孩子在 2k 和 2k+1，查找从根往下走，每层只有一次比较和一次移位，没有分支；
+// 树顶几层总在缓存里，往下每层顺带预取三层以后的 8 个后代（8 个 64 位哈希正好一条缓存行）。
+// 数组补齐到满二叉树，补位的值为最大值、归属环上第一个节点，这样每次查找走的层数相同，
+// 超过最后一个虚拟节点时自然绕回第一个，不用单独判断（恰好是满二叉树时落到下标 0，同样归第一个节点）
+class FlatRing {
+private:
+    std::vector<size_t> points;    // 下标从 1 开始，points[0] 不用
+    std::vector<uint32_t> owners;  // 与 points 并行
+    int depth = 0;
+
+    // 把有序数组 sorted 按中序依次填进以 k 为根的子树
+    void fill(const std::vector<std::pair<size_t, uint32_t>>& sorted, size_t& next, size_t k) {
+        if (k >= points.size()) return;
+        fill(sorted, next, 2 * k);
+        points[k] = sorted[next].first;
+        owners[k] = sorted[next].second;
+        next++;
+        fill(sorted, next, 2 * k + 1);
+    }
+
+    // 下降结束时 k 的二进制是 1 加上一路的左右选择（左 0 右 1），
+    // 去掉末尾连续的 1 和它前面的那个 0，剩下的就是第一个不小于 h 的元素
+    static size_t settle(size_t k) {
+        return k >> __builtin_ffsll(static_cast<long long>(~k));
+    }
+
+public:
+    // ring 为哈希值到节点下标的有序映射，成员变化后整体重建
+    void build(const std::map<size_t, uint32_t>& ring) {
+        points.clear();
+        owners.clear();
+        depth = 0;
+        if (ring.empty()) return;
+        size_t full = 1;
+        while (full - 1 < ring.size()) {
+            full <<= 1;
+            depth++;
+        }
+        std::vector<std::pair<size_t, uint32_t>> sorted(ring.begin(), ring.end());
+        sorted.resize(full - 1, {SIZE_MAX, ring.begin()->second});
+        points.assign(full, 0);
+        owners.assign(full, ring.begin()->second);  // owners[0]：没有补位时比所有哈希值都大的 h 落到这里
+        size_t next = 0;
+        fill(sorted, next, 1);
+    }
+
+    bool empty() const { return depth == 0; }
+
+    // 顺时针方向第一个哈希值不小于 h 的虚拟节点所属的节点下标
+    uint32_t lookup(size_t h) const {
+        size_t k = 1;
+        for (int level = 0; level < depth; ++level) {
+            __builtin_prefetch(points.data() + k * 8);
+            k = 2 * k + (points[k] < h);
+        }
+        return owners[settle(k)];
+    }
+
+    // 一组哈希值同时往下走：每层先把这一组的比较都做完、预取各自下一层的元素，
+    // 缓存未命中的等待互相重叠，不再一个接一个地等内存
+    template <size_t kGroup>
+    void lookupGroup(const size_t* hashes, size_t count, uint32_t* out) const {
+        size_t k[kGroup];
+        for (size_t i = 0; i < count; ++i) k[i] = 1;
+        for (int level = 0; level < depth; ++level) {
+            for (size_t i = 0; i < count; ++i) {
+                k[i] = 2 * k[i] + (points[k[i]] < hashes[i]);
+                __builtin_prefetch(points.data() + k[i]);
+            }
+        }
+        for (size_t i = 0; i < count; ++i) out[i] = owners[settle(k[i])];
+    }
+
+    // 沿环行走用的位置：lookup 落到的元素在数组中的下标，绕回时换成环上第一个元素
+    size_t locate(size_t h) const {
+        size_t k = 1;
+        for (int level = 0; level < depth; ++level) k = 2 * k + (points[k] < h);
+        k = settle(k);
+        return k == 0 ? first() : k;
+    }
+
+    // 顺时针的下一个位置：有右子树时是右子树最左边的元素，否则是中序的下一个祖先，与 settle 同一个算法；
+    // 补位的元素排在最后，都归第一个节点，走过它们只是把第一个节点多看几遍
+    size_t next(size_t k) const {
+        if (2 * k + 1 < points.size()) {
+            k = 2 * k + 1;
+            while (2 * k < points.size()) k = 2 * k;
+            return k;
+        }
+        k = settle(k);
+        return k == 0 ? first() : k;
+    }
+
+    size_t first() const { return size_t(1) << (depth - 1); }
+
+    uint32_t owner(size_t k) const { return owners[k]; }
+
+    // 含补位的元素个数，沿环走这么多步正好一圈
+    size_t size() const { return points.empty() ? 0 : points.size() - 1; }
+
+    size_t memoryBytes() const {
+        return points.capacity() * sizeof(size_t) + owners.capacity() * sizeof(uint32_t);
+    }
+};
 
 class ConsistentHash {
 private:
+    struct NodeInfo {
+        uint32_t index;
+        std::vector<size_t> points;  // 该节点的虚拟节点哈希值
+    };
+
     // 虚拟节点倍数
     int virtualNodes;
-    // 哈希环
-    std::map<size_t, std::string> ring;
+    // 哈希环：虚拟节点哈希值 -> 节点下标，增删节点时修改
+    std::map<size_t, uint32_t> ring;
+    // 查找用的冻结副本，每次增删节点后从 ring 重建
+    FlatRing flat;
+    // 节点下标 -> 节点名，删除的节点留空，下标给后来的节点复用
+    std::vector<std::string> nodeNames;
+    std::vector<uint32_t> freeIndexes;
     // 物理节点到虚拟节点的映射
-    std::unordered_map<std::string, std::vector<size_t>> nodeToVirtual;
-    
-    // 哈希函数
-    size_t hash(const std::string& key) {
-        return std::hash<std::string>{}(key);
+    std::unordered_map<std::string, NodeInfo> nodeToVirtual;
+    // 有界负载的计数：每个节点下标上正在处理的请求数和总数。原子变量本身不能复制，
+    // 这里复制时取一份当时的快照，ConsistentHash 仍然可以像以前一样复制和移动
+    struct LoadCounters {
+        std::deque<std::atomic<uint32_t>> perNode;
+        std::atomic<uint64_t> total{0};
+
+        LoadCounters() = default;
+        LoadCounters(const LoadCounters& other) { *this = other; }
+        LoadCounters& operator=(const LoadCounters& other) {
+            if (this == &other) return *this;
+            perNode.clear();
+            for (const auto& load : other.perNode) perNode.emplace_back(load.load(std::memory_order_relaxed));
+            total.store(other.total.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            return *this;
+        }
+    };
+    LoadCounters loads;
+    double loadEpsilon = 0;  // 为 0 时不限制
+
+    // 哈希函数；std::hash<std::string_view> 与 std::hash<std::string> 对相同内容给出相同的值
+    static size_t hash(std::string_view key) {
+        return std::hash<std::string_view>{}(key);
     }
-    
+
     // 生成虚拟节点的key
     std::string getVirtualKey(const std::string& node, int index) {
         std::stringstream ss;
@@ -28,80 +171,339 @@ private:
         return ss.str();
     }
 
+    void checkNotEmpty() const {
+        if (flat.empty()) {
+            throw std::runtime_error("Hash ring is empty");
+        }
+    }
+
 public:
     ConsistentHash(int virtualNodeCount = 3) : virtualNodes(virtualNodeCount) {}
-    
-    // 添加节点
+
+    // 添加节点，已经存在时不做任何事
     void addNode(const std::string& node) {
+        if (nodeToVirtual.count(node)) return;
+        uint32_t index;
+        if (!freeIndexes.empty()) {
+            index = freeIndexes.back();
+            freeIndexes.pop_back();
+            nodeNames[index] = node;
+        } else {
+            index = static_cast<uint32_t>(nodeNames.size());
+            nodeNames.push_back(node);
+            loads.perNode.emplace_back(0);
+        }
+        NodeInfo& info = nodeToVirtual[node];
+        info.index = index;
         // 为物理节点创建虚拟节点
         for (int i = 0; i < virtualNodes; ++i) {
             std::string virtualKey = getVirtualKey(node, i);
             size_t hashValue = hash(virtualKey);
-            ring[hashValue] = node;
-            nodeToVirtual[node].push_back(hashValue);
+            ring[hashValue] = index;
+            info.points.push_back(hashValue);
         }
+        flat.build(ring);
     }
-    
+
     // 删除节点
     void removeNode(const std::string& node) {
         // 删除该节点的所有虚拟节点
         auto it = nodeToVirtual.find(node);
         if (it != nodeToVirtual.end()) {
-            for (size_t hashValue : it->second) {
-                ring.erase(hashValue);
+            uint32_t index = it->second.index;
+            for (size_t hashValue : it->second.points) {
+                // 哈希值撞上了后加入的节点时，这个位置已经归它了
+                auto pos = ring.find(hashValue);
+                if (pos != ring.end() && pos->second == index) ring.erase(pos);
             }
             nodeToVirtual.erase(it);
+            nodeNames[index].clear();
+            freeIndexes.push_back(index);
+            flat.build(ring);
         }
     }
-    
+
     // 获取负责处理key的节点
-    std::string getNode(const std::string& key) {
-        if (ring.empty()) {
-            throw std::runtime_error("Hash ring is empty");
+    std::string getNode(const std::string& key) const {
+        return std::string(nodeName(getNodeIndex(key)));
+    }
+
+    // 负责处理 key 的节点下标，不分配内存；下标在该节点被删除前保持不变
+    uint32_t getNodeIndex(std::string_view key) const {
+        checkNotEmpty();
+        return flat.lookup(hash(key));
+    }
+
+    // 节点下标对应的节点名，在下一次增删节点前有效
+    std::string_view nodeName(uint32_t index) const {
+        return nodeNames[index];
+    }
+
+    // 批量查找：out[i] 为 keys[i] 所在节点的下标。每 16 个 key 一组先算好哈希，再一起在环上查找
+    void getNodes(const std::string_view* keys, size_t count, uint32_t* out) const {
+        constexpr size_t kGroup = 16;
+        checkNotEmpty();
+        size_t hashes[kGroup];
+        for (size_t base = 0; base < count; base += kGroup) {
+            size_t n = std::min(kGroup, count - base);
+            for (size_t i = 0; i < n; ++i) hashes[i] = hash(keys[base + i]);
+            flat.lookupGroup<kGroup>(hashes, n, out + base);
         }
-        
-        size_t hashValue = hash(key);
-        
-        // 找到第一个大于等于hashValue的节点
-        auto it = ring.lower_bound(hashValue);
-        
-        // 如果找不到，则返回第一个节点
-        if (it == ring.end()) {
-            return ring.begin()->second;
+    }
+
+    std::vector<uint32_t> getNodes(const std::vector<std::string_view>& keys) const {
+        std::vector<uint32_t> out(keys.size());
+        getNodes(keys.data(), keys.size(), out.data());
+        return out;
+    }
+
+    // 有界负载（Mirrokni 等，Consistent Hashing with Bounded Loads）：每个节点同时处理的请求不超过
+    // ceil((1+epsilon)·总请求数/节点数)，key 的节点满了就沿环顺时针找下一个还有余量的节点。
+    // 虚拟节点少时环上的区间长短悬殊，负载能差到 2~3 倍，限制之后最忙的节点不超过平均的 1+epsilon 倍，
+    // 代价是一部分 key 不在它原来的节点上处理。epsilon 为 0 时关闭，acquireNode 只做计数
+    void setLoadBound(double epsilon) {
+        if (epsilon < 0) {
+            throw std::invalid_argument("load bound epsilon must be non-negative");
         }
-        
-        return it->second;
+        loadEpsilon = epsilon;
     }
-    
+
+    // 为 key 选一个节点并把它的负载加一，请求处理完后必须用返回的下标调用 releaseNode。
+    // 负载计数都是原子操作，多个线程可以同时 acquireNode/releaseNode；增删节点仍然不能和查找并发
+    uint32_t acquireNode(std::string_view key) {
+        checkNotEmpty();
+        uint64_t total = loads.total.fetch_add(1, std::memory_order_relaxed) + 1;
+        size_t pos = flat.locate(hash(key));
+        if (loadEpsilon == 0) {
+            uint32_t index = flat.owner(pos);
+            loads.perNode[index].fetch_add(1, std::memory_order_relaxed);
+            return index;
+        }
+        for (;;) {
+            // 总容量不小于 (1+epsilon)·total，没有并发时一圈之内一定有节点还有余量；
+            // 其它线程同时占满了这一圈时按新的总数重算容量再走一圈
+            uint32_t capacity = static_cast<uint32_t>(
+                std::ceil((1 + loadEpsilon) * static_cast<double>(total) / static_cast<double>(nodeToVirtual.size())));
+            for (size_t step = 0; step < flat.size(); ++step, pos = flat.next(pos)) {
+                std::atomic<uint32_t>& load = loads.perNode[flat.owner(pos)];
+                uint32_t current = load.load(std::memory_order_relaxed);
+                while (current < capacity) {
+                    if (load.compare_exchange_weak(current, current + 1, std::memory_order_relaxed)) {
+                        return flat.owner(pos);
+                    }
+                }
+            }
+            total = loads.total.load(std::memory_order_relaxed);
+        }
+    }
+
+    // 节点被删除时仍在处理的请求照常释放；它的下标被新节点复用时，新节点先继承这些计数，随释放归零
+    void releaseNode(uint32_t index) {
+        loads.perNode[index].fetch_sub(1, std::memory_order_relaxed);
+        loads.total.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    uint32_t nodeLoad(uint32_t index) const {
+        return loads.perNode[index].load(std::memory_order_relaxed);
+    }
+
     // 打印当前环的状态
     void printRing() {
         std::cout << "Current hash ring state:" << std::endl;
         for (const auto& pair : ring) {
-            std::cout << "Hash: " << pair.first << " -> Node: " << pair.second << std::endl;
+            std::cout << "Hash: " << pair.first << " -> Node: " << nodeNames[pair.second] << std::endl;
         }
         std::cout << std::endl;
     }
 };
 
+// Jump Consistent Hash（Lamping & Veach）：不存环，O(1) 内存，查找 O(log n) 次乘法，各节点分到的 key 几乎完全均匀。
+// 代价是节点只能编号为 0..n-1：在末尾增删节点时只有 1/n 的 key 移动；删除中间的节点时把最后一个节点挪到它的编号上，
+// 这两个节点的 key 都要移动，约 2/n
+class JumpHash {
+private:
+    std::vector<std::string> buckets;  // 编号 -> 节点名
+    std::unordered_map<std::string, uint32_t> nodeToBucket;
+
+    static size_t hash(std::string_view key) {
+        return std::hash<std::string_view>{}(key);
+    }
+
+    static uint32_t jump(uint64_t key, uint32_t bucketCount) {
+        int64_t b = -1, j = 0;
+        while (j < static_cast<int64_t>(bucketCount)) {
+            b = j;
+            key = key * 2862933555777941757ULL + 1;
+            j = static_cast<int64_t>((b + 1) * (static_cast<double>(1LL << 31) / static_cast<double>((key >> 33) + 1)));
+        }
+        return static_cast<uint32_t>(b);
+    }
+
+public:
+    void addNode(const std::string& node) {
+        if (nodeToBucket.count(node)) return;
+        nodeToBucket[node] = static_cast<uint32_t>(buckets.size());
+        buckets.push_back(node);
+    }
+
+    void removeNode(const std::string& node) {
+        auto it = nodeToBucket.find(node);
+        if (it == nodeToBucket.end()) return;
+        uint32_t bucket = it->second;
+        nodeToBucket.erase(it);
+        if (bucket + 1 != buckets.size()) {
+            buckets[bucket] = std::move(buckets.back());
+            nodeToBucket[buckets[bucket]] = bucket;
+        }
+        buckets.pop_back();
+    }
+
+    std::string getNode(const std::string& key) const {
+        return std::string(nodeName(getNodeIndex(key)));
+    }
+
+    // 节点下标即编号，删除节点后最后一个节点的编号会变
+    uint32_t getNodeIndex(std::string_view key) const {
+        if (buckets.empty()) {
+            throw std::runtime_error("Hash ring is empty");
+        }
+        return jump(hash(key), static_cast<uint32_t>(buckets.size()));
+    }
+
+    std::string_view nodeName(uint32_t index) const {
+        return buckets[index];
+    }
+};
+
+// Maglev 查找表（Google Maglev 负载均衡器）：每个节点按名字的两个哈希值 offset、skip 生成 0..M-1 的一个排列，
+// 各节点轮流按自己的排列占表项，直到 M 个表项都被占满。查找只是 table[hash(key) % M]，O(1)，一次内存访问；
+// 每个节点分到的表项数相差不超过 1，负载几乎均匀。成员变化时整表重建，O(M log M) 左右，
+// 大部分表项保持原主人，只有少量 key 额外移动。M 取质数，一般不小于节点数的 100 倍
+class MaglevHash {
+private:
+    uint32_t tableSize;
+    std::vector<uint32_t> table;  // 表项 -> 节点下标
+    std::vector<std::string> nodeNames;  // 删除的节点留空，下标给后来的节点复用
+    std::vector<uint32_t> freeIndexes;
+    std::unordered_map<std::string, uint32_t> nodeToIndex;
+
+    static size_t hash(std::string_view key) {
+        return std::hash<std::string_view>{}(key);
+    }
+
+    static uint64_t mix(uint64_t x) {
+        x += 0x9e3779b97f4a7c15ULL;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+
+    static bool isPrime(uint32_t n) {
+        if (n < 2) return false;
+        for (uint32_t d = 2; static_cast<uint64_t>(d) * d <= n; ++d) {
+            if (n % d == 0) return false;
+        }
+        return true;
+    }
+
+    void rebuild() {
+        struct Cursor {
+            uint32_t index;
+            uint32_t offset;
+            uint32_t skip;
+            uint32_t next = 0;  // 排列里下一个要试的位置
+        };
+        std::vector<Cursor> cursors;
+        for (uint32_t i = 0; i < nodeNames.size(); ++i) {
+            if (nodeNames[i].empty()) continue;
+            uint64_t h = hash(nodeNames[i]);
+            cursors.push_back({i, static_cast<uint32_t>(h % tableSize),
+                               static_cast<uint32_t>(mix(h) % (tableSize - 1)) + 1});
+        }
+        table.assign(cursors.empty() ? 0 : tableSize, UINT32_MAX);
+        size_t filled = 0;
+        while (filled < table.size()) {
+            for (Cursor& c : cursors) {
+                uint32_t slot;
+                do {
+                    slot = static_cast<uint32_t>((c.offset + static_cast<uint64_t>(c.skip) * c.next++) % tableSize);
+                } while (table[slot] != UINT32_MAX);
+                table[slot] = c.index;
+                if (++filled == table.size()) break;
+            }
+        }
+    }
+
+public:
+    // tableSize 向上取到质数
+    explicit MaglevHash(uint32_t tableSize = 65537) : tableSize(std::max<uint32_t>(tableSize, 3)) {
+        while (!isPrime(this->tableSize)) this->tableSize++;
+    }
+
+    void addNode(const std::string& node) {
+        if (nodeToIndex.count(node)) return;
+        uint32_t index;
+        if (!freeIndexes.empty()) {
+            index = freeIndexes.back();
+            freeIndexes.pop_back();
+            nodeNames[index] = node;
+        } else {
+            index = static_cast<uint32_t>(nodeNames.size());
+            nodeNames.push_back(node);
+        }
+        nodeToIndex[node] = index;
+        rebuild();
+    }
+
+    void removeNode(const std::string& node) {
+        auto it = nodeToIndex.find(node);
+        if (it == nodeToIndex.end()) return;
+        nodeNames[it->second].clear();
+        freeIndexes.push_back(it->second);
+        nodeToIndex.erase(it);
+        rebuild();
+    }
+
+    std::string getNode(const std::string& key) const {
+        return std::string(nodeName(getNodeIndex(key)));
+    }
+
+    // 负责处理 key 的节点下标；下标在该节点被删除前保持不变
+    uint32_t getNodeIndex(std::string_view key) const {
+        if (table.empty()) {
+            throw std::runtime_error("Hash ring is empty");
+        }
+        return table[hash(key) % tableSize];
+    }
+
+    std::string_view nodeName(uint32_t index) const {
+        return nodeNames[index];
+    }
+};
+
+#ifndef NO_MAIN
+#include <malloc.h>
+#include <thread>
+
 // 测试代码
 void testConsistentHash() {
     ConsistentHash ch(3);  // 每个物理节点创建3个虚拟节点
-    
+
     // 添加节点
     std::vector<std::string> nodes = {"node1", "node2", "node3", "node4"};
     for (const auto& node : nodes) {
         ch.addNode(node);
     }
-    
+
     // 测试key的分配
     std::vector<std::string> keys = {"key1", "key2", "key3", "key4", "key5"};
-    
+
     std::cout << "Initial distribution:" << std::endl;
     for (const auto& key : keys) {
         std::cout << "Key: " << key << " -> Node: " << ch.getNode(key) << std::endl;
     }
     std::cout << std::endl;
-    
+
     // 删除一个节点
     std::cout << "After removing node2:" << std::endl;
     ch.removeNode("node2");
@@ -109,7 +511,7 @@ void testConsistentHash() {
         std::cout << "Key: " << key << " -> Node: " << ch.getNode(key) << std::endl;
     }
     std::cout << std::endl;
-    
+
     // 添加新节点
     std::cout << "After adding node5:" << std::endl;
     ch.addNode("node5");
@@ -118,7 +520,251 @@ void testConsistentHash() {
     }
 }
 
-int main() {
+std::string nodeAddress(int i) {
+    return "10.0." + std::to_string(i / 256) + "." + std::to_string(i % 256) + ":6379";
+}
+
+// 查找速度：nodeCount 个节点、每个 virtualNodeCount 个虚拟节点，对 keyCount 个不同的 key 各查一次。
+// 对比改造前的 std::map::lower_bound 加返回 std::string、有序数组上的 std::lower_bound、
+// Eytzinger 单个查找和批量查找；第一行只算哈希，是所有做法共同的下限
+void benchmarkLookup(int nodeCount, int virtualNodeCount, size_t keyCount) {
+    ConsistentHash ch(virtualNodeCount);
+    std::map<size_t, std::string> oldRing;
+    for (int i = 0; i < nodeCount; ++i) {
+        std::string node = nodeAddress(i);
+        ch.addNode(node);
+        for (int v = 0; v < virtualNodeCount; ++v) {
+            std::string virtualKey = node + "#" + std::to_string(v);
+            oldRing[std::hash<std::string>{}(virtualKey)] = node;
+        }
+    }
+    std::vector<size_t> sortedHashes;
+    for (const auto& pair : oldRing) sortedHashes.push_back(pair.first);
+
+    std::vector<std::string> keys(keyCount);
+    std::mt19937_64 rng(1);
+    for (auto& key : keys) key = "user:" + std::to_string(rng() % 100000000) + ":session";
+    std::vector<std::string_view> views(keys.begin(), keys.end());
+    std::vector<uint32_t> out(keyCount);
+
+    auto run = [&](const char* name, auto&& body) {
+        auto start = std::chrono::steady_clock::now();
+        size_t check = body();
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "  " << name << " " << keyCount / secs / 1e6 << " M lookups/s (" << secs * 1e9 / keyCount
+                  << " ns), checksum " << check << std::endl;
+    };
+    std::cout << nodeCount << " nodes x " << virtualNodeCount << " virtual = " << oldRing.size() << " points, "
+              << keyCount << " keys" << std::endl;
+    run("hash only:             ", [&] {
+        size_t sum = 0;
+        for (const auto& key : keys) sum += std::hash<std::string>{}(key) >> 60;
+        return sum;
+    });
+    run("std::map + std::string:", [&] {
+        size_t sum = 0;
+        for (const auto& key : keys) {
+            auto it = oldRing.lower_bound(std::hash<std::string>{}(key));
+            std::string node = it == oldRing.end() ? oldRing.begin()->second : it->second;
+            sum += node.size();
+        }
+        return sum;
+    });
+    run("sorted std::lower_bound:", [&] {
+        size_t sum = 0;
+        for (const auto& key : keys) {
+            auto it = std::lower_bound(sortedHashes.begin(), sortedHashes.end(), std::hash<std::string>{}(key));
+            sum += it == sortedHashes.end() ? 0 : static_cast<size_t>(it - sortedHashes.begin()) & 7;
+        }
+        return sum;
+    });
+    run("Eytzinger getNodeIndex:", [&] {
+        size_t sum = 0;
+        for (const auto& key : keys) sum += ch.nodeName(ch.getNodeIndex(key)).size();
+        return sum;
+    });
+    run("Eytzinger getNodes:    ", [&] {
+        ch.getNodes(views.data(), views.size(), out.data());
+        size_t sum = 0;
+        for (uint32_t index : out) sum += ch.nodeName(index).size();
+        return sum;
+    });
+}
+
+// 大块内存由 mmap 分配，计入 hblkhd 而不是 uordblks
+size_t heapBytes() {
+    struct mallinfo2 mi = mallinfo2();
+    return mi.uordblks + mi.hblkhd;
+}
+
+// 每个 key 归属的节点名（按下标映射回名字，节点下标在增删后可能被复用或改变）
+template <typename Engine>
+std::vector<std::string> owners(const Engine& engine, const std::vector<std::string_view>& keys) {
+    std::vector<std::string> names;
+    names.reserve(keys.size());
+    for (std::string_view key : keys) names.emplace_back(engine.nodeName(engine.getNodeIndex(key)));
+    return names;
+}
+
+size_t countMoved(const std::vector<std::string>& before, const std::vector<std::string>& after) {
+    size_t moved = 0;
+    for (size_t i = 0; i < before.size(); ++i) moved += before[i] != after[i];
+    return moved;
+}
+
+// 对一种实现测：建表占用的堆内存、查找速度、负载均衡（最多的节点分到的 key 数 / 平均数）、
+// 删掉中间一个节点和新加一个节点时移动的 key 比例（理想值分别为 1/n 和 1/(n+1)）
+template <typename Engine>
+void compareEngine(const char* name, Engine engine, int nodeCount, const std::vector<std::string_view>& keys) {
+    size_t before = heapBytes();
+    for (int i = 0; i < nodeCount; ++i) engine.addNode(nodeAddress(i));
+    size_t bytes = heapBytes() - before;
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<uint32_t> load;
+    for (std::string_view key : keys) {
+        uint32_t index = engine.getNodeIndex(key);
+        if (index >= load.size()) load.resize(index + 1, 0);
+        load[index]++;
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double mean = static_cast<double>(keys.size()) / nodeCount;
+    double maxLoad = *std::max_element(load.begin(), load.end());
+
+    std::vector<std::string> initial = owners(engine, keys);
+    engine.removeNode(nodeAddress(nodeCount / 2));
+    std::vector<std::string> afterRemove = owners(engine, keys);
+    engine.addNode(nodeAddress(nodeCount / 2));
+    engine.addNode(nodeAddress(nodeCount));
+    std::vector<std::string> afterAdd = owners(engine, keys);
+    engine.removeNode(nodeAddress(nodeCount));
+    std::vector<std::string> restored = owners(engine, keys);
+    double removed = 100.0 * countMoved(initial, afterRemove) / keys.size();
+    double added = 100.0 * countMoved(restored, afterAdd) / keys.size();
+
+    std::cout << "  " << name << " " << secs * 1e9 / keys.size() << " ns/lookup, " << bytes / 1024 << " KB, max/mean "
+              << maxLoad / mean << ", remove one moves " << removed << "%, add one moves " << added << "%" << std::endl;
+}
+
+void compareEngines(int nodeCount, size_t keyCount) {
+    std::vector<std::string> keys(keyCount);
+    std::mt19937_64 rng(2);
+    for (auto& key : keys) key = "user:" + std::to_string(rng() % 1000000000) + ":session";
+    std::vector<std::string_view> views(keys.begin(), keys.end());
+    std::cout << nodeCount << " nodes, " << keyCount << " keys (ideal: remove " << 100.0 / nodeCount << "%, add "
+              << 100.0 / (nodeCount + 1) << "%)" << std::endl;
+    compareEngine("ring, 3 virtual:    ", ConsistentHash(3), nodeCount, views);
+    compareEngine("ring, 160 virtual:  ", ConsistentHash(160), nodeCount, views);
+    compareEngine("jump:               ", JumpHash(), nodeCount, views);
+    compareEngine("maglev, M=100n:     ", MaglevHash(static_cast<uint32_t>(100 * nodeCount)), nodeCount, views);
+    compareEngine("maglev, M=1000n:    ", MaglevHash(static_cast<uint32_t>(1000 * nodeCount)), nodeCount, views);
+}
+
+// 有界负载的模拟：始终有 64·nodeCount 个请求在处理，每一步随机结束一个、再来一个新请求。
+// key 取自 100 万个不同的 key 均匀抽样，或者 1 万个 key 按 Zipf(1) 抽样（少数热点 key 占大部分请求）。
+// 每 nodeCount 步记一次最忙节点的负载与平均负载之比，报告全程的最大值和平均值，
+// 以及不在 key 原来节点上处理的请求比例
+void simulateBoundedLoad(int nodeCount, int virtualNodeCount, double epsilon, bool zipf, size_t steps) {
+    ConsistentHash ch(virtualNodeCount);
+    for (int i = 0; i < nodeCount; ++i) ch.addNode(nodeAddress(i));
+    ch.setLoadBound(epsilon);
+
+    std::mt19937_64 rng(3);
+    std::vector<std::string> keys(zipf ? 10000 : 1000000);
+    for (size_t i = 0; i < keys.size(); ++i) keys[i] = "user:" + std::to_string(i) + ":session";
+    std::vector<double> cdf(keys.size());
+    double sum = 0;
+    for (size_t i = 0; i < cdf.size(); ++i) cdf[i] = sum += zipf ? 1.0 / static_cast<double>(i + 1) : 1.0;
+    std::uniform_real_distribution<double> uniform(0, sum);
+    auto pick = [&]() -> const std::string& {
+        return keys[std::min(cdf.size() - 1, static_cast<size_t>(
+            std::lower_bound(cdf.begin(), cdf.end(), uniform(rng)) - cdf.begin()))];
+    };
+
+    size_t window = 64 * static_cast<size_t>(nodeCount);
+    double mean = static_cast<double>(window) / nodeCount;
+    std::vector<uint32_t> inFlight;
+    size_t displaced = 0, samples = 0;
+    double worst = 0, ratioSum = 0;
+    for (size_t step = 0; step < window + steps; ++step) {
+        const std::string& key = pick();
+        uint32_t index = ch.acquireNode(key);
+        if (step >= window) {
+            displaced += index != ch.getNodeIndex(key);
+            size_t victim = rng() % inFlight.size();
+            ch.releaseNode(inFlight[victim]);
+            inFlight[victim] = index;
+        } else {
+            inFlight.push_back(index);
+        }
+        if (step >= window && step % nodeCount == 0) {
+            uint32_t maxLoad = 0;
+            for (int i = 0; i < nodeCount; ++i) maxLoad = std::max(maxLoad, ch.nodeLoad(i));
+            worst = std::max(worst, maxLoad / mean);
+            ratioSum += maxLoad / mean;
+            samples++;
+        }
+    }
+    std::cout << "  " << (zipf ? "zipf   " : "uniform") << " vnodes " << virtualNodeCount << ", epsilon "
+              << (epsilon == 0 ? std::string("off ") : std::to_string(epsilon).substr(0, 4)) << ": max/mean peak "
+              << worst << ", average " << ratioSum / samples << ", displaced "
+              << 100.0 * displaced / steps << "%" << std::endl;
+}
+
+// 多个线程同时 acquireNode/releaseNode：每个线程自己维持一批在处理的请求。
+// 报告每秒完成的请求数，结束后检查所有计数都回到了 0
+void concurrentBoundedLoad(int threadCount, size_t perThread) {
+    ConsistentHash ch(3);
+    for (int i = 0; i < 100; ++i) ch.addNode(nodeAddress(i));
+    ch.setLoadBound(0.25);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&, t] {
+            std::mt19937_64 rng(t);
+            std::vector<uint32_t> inFlight;
+            for (size_t i = 0; i < perThread; ++i) {
+                inFlight.push_back(ch.acquireNode("user:" + std::to_string(rng() % 1000000)));
+                if (inFlight.size() == 64) {
+                    for (uint32_t index : inFlight) ch.releaseNode(index);
+                    inFlight.clear();
+                }
+            }
+            for (uint32_t index : inFlight) ch.releaseNode(index);
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    uint32_t left = 0;
+    for (int n = 0; n < 100; ++n) left += ch.nodeLoad(n);
+    std::cout << "  " << threadCount << " threads: " << threadCount * perThread / secs / 1e6
+              << "M acquire+release/s, "
+              << left << " left after release" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && std::string(argv[1]) == "bench") {
+        benchmarkLookup(100, 3, 2000000);
+        benchmarkLookup(100, 100, 2000000);
+        benchmarkLookup(1000, 200, 2000000);
+        return 0;
+    }
+    if (argc > 1 && std::string(argv[1]) == "engines") {
+        compareEngines(100, 1000000);
+        compareEngines(1000, 1000000);
+        return 0;
+    }
+    if (argc > 1 && std::string(argv[1]) == "bounded") {
+        std::cout << "100 nodes, 6400 requests in flight" << std::endl;
+        for (bool zipf : {false, true}) {
+            for (int vnodes : {3, 100}) {
+                for (double epsilon : {0.0, 0.25, 0.1}) simulateBoundedLoad(100, vnodes, epsilon, zipf, 2000000);
+            }
+        }
+        concurrentBoundedLoad(1, 2000000);
+        concurrentBoundedLoad(4, 500000);
+        return 0;
+    }
     try {
         testConsistentHash();
     } catch (const std::exception& e) {
@@ -126,4 +772,5 @@ int main() {
         return 1;
     }
     return 0;
-}
\ No newline at end of file
+}
+#endif
@@ -1,109 +1,1304 @@
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
 #include <functional>
 #include <iostream>
+#include <malloc.h>
+#include <memory>
 #include <mutex>
+#include <new>
 #include <queue>
+#include <random>
+#include <stdexcept>
+#include <string>
 #include <thread>
 #include <vector>
 
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+// 周期定时器下一次的到期时间怎么算。回调执行完之后才重新排期，同一个周期定时器的两次回调不会重叠
+enum class RepeatMode : uint8_t {
+  FixedRate,     // 固定频率：上一次的到期时间加周期，不随执行时间漂移；错过的几次紧接着补上
+  FixedRateSkip, // 固定频率，但错过的不补：执行完时已经过去的到期点跳过，对齐到下一个
+  FixedDelay,    // 固定间隔：上一次回调执行完毕后再过一个周期
+};
+
+// 周期定时器执行完后的下一个到期时间，now 为执行完毕的时刻
+inline uint64_t nextExpire(uint64_t expire, uint64_t period, RepeatMode mode, uint64_t now) {
+  if (mode == RepeatMode::FixedDelay) return now + period;
+  expire += period;
+  if (mode == RepeatMode::FixedRateSkip && expire <= now) expire += ((now - expire) / period + 1) * period;
+  return expire;
+}
+
+// 定时器允许晚 slack 触发时，到期时间向上对齐到 2^slackBits（不超过 slack 的最大的 2 的幂）的整数倍。
+// 误差范围相近的定时器落到同一个时刻上，一次唤醒一起处理，而不是各自唤醒一次（即 Linux 的 timer slack）
+inline uint64_t alignUp(uint64_t expire, unsigned slackBits) {
+  uint64_t mask = (uint64_t(1) << slackBits) - 1;
+  return (expire + mask) & ~mask;
+}
+
+// 分层时间轮：kLevels 层，每层 64 个槽位，第 L 层的一个槽位覆盖 64^L 个 tick。
+// 到期 tick 距当前不足 64 的定时器放进第 0 层对应的槽位，更远的按距离放到更高层；
+// 当前 tick 走到高层某个槽位的起点时，把槽里的定时器按剩余距离重新分到低层（级联）。
+// 定时器节点放在一个数组里，按下标串成各槽位的双向链表，空闲节点复用。
+// 句柄由节点下标和代数组成，节点每次释放代数加一，已经到期或取消的句柄不会误删别的定时器。
+// 添加、取消和改期都是 O(1)，取消时立即释放回调；每层一个 64 位的占用位图，空转时直接跳到下一个有事可做的 tick。
+// 周期定时器到期后回调连同句柄交给调用方，节点留着，执行完后调用方用 rearm 还回回调，在原节点上重新放置，
+// 整个过程不分配内存，句柄不变
+class TimingWheel {
+public:
+  using Handle = uint64_t; // 高 32 位为代数，低 32 位为节点下标，0 不会是有效句柄
+
+private:
+  static constexpr int kBits = 6;
+  static constexpr uint64_t kSlots = 1ull << kBits;
+  static constexpr int kLevels = 6; // 共 2^36 个 tick，1ms 一个 tick 约两年
+  static constexpr uint32_t kNil = UINT32_MAX;
+  static constexpr uint16_t kExpiring = kLevels * kSlots; // 正在触发的链表
+  // 不在任何链表上的状态：周期定时器的回调正在执行，执行期间被取消，执行期间被改期（expire 为新的到期 tick）
+  static constexpr uint16_t kRunning = kExpiring + 1;
+  static constexpr uint16_t kCancelled = kExpiring + 2;
+  static constexpr uint16_t kMoved = kExpiring + 3;
+  static constexpr uint16_t kFree = UINT16_MAX;
+
+  struct Node {
+    uint64_t expire = 0; // 到期 tick
+    uint64_t period = 0; // 周期（tick），0 表示一次性
+    std::function<void()> callback;
+    uint32_t prev = kNil;
+    uint32_t next = kNil;
+    uint32_t generation = 1;
+    uint16_t list = kFree; // 所在链表：level * kSlots + 槽位，kExpiring，或上面几种不在链表上的状态
+    RepeatMode mode = RepeatMode::FixedRate;
+    uint8_t slackBits = 0; // expire 是名义到期 tick，按 alignUp(expire, slackBits) 放置
+  };
+
+  std::vector<Node> nodes;
+  uint32_t freeList = kNil;
+  uint32_t heads[kLevels * kSlots + 1];
+  uint64_t occupied[kLevels] = {}; // 每层非空槽位的位图
+  uint64_t current;                // 下一个要处理的 tick
+  size_t count = 0;
+
+  static uint64_t rotr(uint64_t x, unsigned r) {
+    return r == 0 ? x : (x >> r) | (x << (64 - r));
+  }
+
+  void pushFront(uint32_t i, uint16_t list) {
+    Node &n = nodes[i];
+    n.list = list;
+    n.prev = kNil;
+    n.next = heads[list];
+    if (n.next != kNil) nodes[n.next].prev = i;
+    heads[list] = i;
+    if (list < kExpiring) occupied[list / kSlots] |= 1ull << (list % kSlots);
+  }
+
+  void unlink(uint32_t i) {
+    Node &n = nodes[i];
+    if (n.prev != kNil) nodes[n.prev].next = n.next;
+    else heads[n.list] = n.next;
+    if (n.next != kNil) nodes[n.next].prev = n.prev;
+    if (n.list < kExpiring && heads[n.list] == kNil) {
+      occupied[n.list / kSlots] &= ~(1ull << (n.list % kSlots));
+    }
+  }
+
+  // 按到期 tick 与 current 的距离选层：距离在 [64^L, 64^(L+1)) 的放第 L 层。
+  // 超出最高层范围的先放在最高层最远的槽位，级联时再重新计算。
+  // 节点里的 expire 保持名义值（周期定时器据此算下一次），已经过去的只在这里按 current 放置
+  void place(uint32_t i) {
+    uint64_t expire = std::max(alignUp(nodes[i].expire, nodes[i].slackBits), current);
+    uint64_t delta = expire - current;
+    int level = delta < kSlots ? 0 : (63 - __builtin_clzll(delta)) / kBits;
+    if (level >= kLevels) {
+      level = kLevels - 1;
+      expire = current + (1ull << (kBits * kLevels)) - 1;
+    }
+    pushFront(i, static_cast<uint16_t>(level * kSlots + ((expire >> (kBits * level)) & (kSlots - 1))));
+  }
+
+  void release(uint32_t i) {
+    Node &n = nodes[i];
+    n.callback = nullptr;
+    n.list = kFree;
+    n.generation++;
+    n.next = freeList;
+    freeList = i;
+    count--;
+  }
+
+  uint32_t find(Handle handle) const {
+    uint32_t i = static_cast<uint32_t>(handle);
+    if (i >= nodes.size() || nodes[i].generation != static_cast<uint32_t>(handle >> 32) ||
+        nodes[i].list == kFree || nodes[i].list == kCancelled) {
+      return kNil;
+    }
+    return i;
+  }
+
+  Handle handleOf(uint32_t i) const {
+    return (static_cast<uint64_t>(nodes[i].generation) << 32) | i;
+  }
+
+  // 把第 level 层的一个槽位整体摘下，逐个按剩余距离重新放置
+  void cascade(int level, uint64_t index) {
+    uint16_t list = static_cast<uint16_t>(level * kSlots + index);
+    uint32_t i = heads[list];
+    heads[list] = kNil;
+    occupied[level] &= ~(1ull << index);
+    while (i != kNil) {
+      uint32_t next = nodes[i].next;
+      place(i);
+      i = next;
+    }
+  }
+
+public:
+  explicit TimingWheel(uint64_t startTick = 0) : current(startTick) {
+    std::fill(std::begin(heads), std::end(heads), kNil);
+  }
+
+  TimingWheel(const TimingWheel &) = delete;
+  TimingWheel &operator=(const TimingWheel &) = delete;
+
+  bool empty() const { return count == 0; }
+  size_t size() const { return count; } // 含回调正在执行的周期定时器
+
+  // 在第 expire 个 tick 触发，period 不为 0 时此后按 mode 每 period 个 tick 触发一次；
+  // 已经过去的 tick 按下一个要处理的 tick 算。slackBits 不为 0 时每次的到期 tick 向上对齐到 2^slackBits
+  Handle add(uint64_t expire, std::function<void()> callback, uint64_t period = 0,
+             RepeatMode mode = RepeatMode::FixedRate, unsigned slackBits = 0) {
+    uint32_t i = freeList;
+    if (i != kNil) {
+      freeList = nodes[i].next;
+    } else {
+      i = static_cast<uint32_t>(nodes.size());
+      nodes.emplace_back();
+    }
+    Node &n = nodes[i];
+    n.expire = expire;
+    n.period = period;
+    n.mode = mode;
+    n.slackBits = static_cast<uint8_t>(slackBits);
+    n.callback = std::move(callback);
+    place(i);
+    count++;
+    return handleOf(i);
+  }
+
+  // 取消尚未触发的定时器，回调立即释放；句柄已经失效时返回 false。
+  // 周期定时器的回调正在执行时先做标记，rearm 时再释放
+  bool cancel(Handle handle) {
+    uint32_t i = find(handle);
+    if (i == kNil) return false;
+    if (nodes[i].list == kRunning || nodes[i].list == kMoved) {
+      nodes[i].list = kCancelled;
+      return true;
+    }
+    unlink(i);
+    release(i);
+    return true;
+  }
+
+  // 把定时器（周期定时器为下一次）改到第 expire 个 tick 触发；句柄已经失效时返回 false。
+  // 推迟时节点留在原槽位，只改到期 tick：原槽位被处理的时刻不晚于原到期 tick，
+  // 到时候按新的到期 tick 重新放置即可。续期比提前常见得多，这样只碰一个节点
+  bool reschedule(Handle handle, uint64_t expire) {
+    uint32_t i = find(handle);
+    if (i == kNil) return false;
+    Node &n = nodes[i];
+    if (n.list == kRunning || n.list == kMoved) {
+      n.expire = expire; // rearm 时直接用它，不再按周期计算
+      n.list = kMoved;
+      return true;
+    }
+    if (expire >= n.expire) {
+      n.expire = expire;
+      return true;
+    }
+    unlink(i);
+    n.expire = expire;
+    place(i);
+    return true;
+  }
+
+  // 下一个需要处理的 tick（有定时器到期或有槽位要级联），没有定时器时返回 UINT64_MAX。
+  // 高层槽位给出的是级联时刻，不一定有定时器到期，调用方按它等待再推进即可
+  uint64_t nextTick() const {
+    if (count == 0) return UINT64_MAX;
+    if (heads[kExpiring] != kNil) return current;
+    uint64_t best = UINT64_MAX;
+    if (occupied[0] != 0) {
+      best = current + __builtin_ctzll(rotr(occupied[0], current & (kSlots - 1)));
+    }
+    for (int level = 1; level < kLevels; level++) {
+      if (occupied[level] == 0) continue;
+      unsigned shift = kBits * level;
+      uint64_t bits = rotr(occupied[level], (current >> shift) & (kSlots - 1));
+      // 当前槽位在本块起点已经级联过，里面的定时器属于下一圈
+      bool aligned = (current & ((1ull << shift) - 1)) == 0;
+      if (!aligned) bits &= ~1ull;
+      uint64_t k = bits != 0 ? __builtin_ctzll(bits) : kSlots;
+      best = std::min(best, ((current >> shift) + k) << shift);
+    }
+    return best;
+  }
+
+  // 周期定时器的回调执行完毕，now 为执行完的 tick：把回调放回节点，按 mode 算出下一次的到期 tick 重新放置。
+  // 执行期间被取消的在这里释放并返回 false
+  bool rearm(Handle handle, std::function<void()> &&callback, uint64_t now) {
+    uint32_t i = static_cast<uint32_t>(handle);
+    if (i >= nodes.size() || nodes[i].generation != static_cast<uint32_t>(handle >> 32)) return false;
+    Node &n = nodes[i];
+    if (n.list == kCancelled) {
+      release(i);
+      return false;
+    }
+    if (n.list != kRunning && n.list != kMoved) return false;
+    if (n.list == kRunning) n.expire = nextExpire(n.expire, n.period, n.mode, now);
+    n.callback = std::move(callback);
+    place(i);
+    return true;
+  }
+
+  // 处理截至 nowTick（含）的所有 tick，对每个到期的定时器调用 onExpire(Handle, std::function<void()>&&)。
+  // 一次性定时器的 Handle 为 0；周期定时器交出的是回调本身，调用方执行完后必须用 rearm 还回来。
+  // onExpire 里可以添加或取消定时器
+  template <typename OnExpire> void advance(uint64_t nowTick, OnExpire &&onExpire) {
+    while (true) {
+      // 逐个触发上一步挪到触发链表上的定时器；onExpire 里新加的定时器进普通槽位，不会混进来
+      while (heads[kExpiring] != kNil) {
+        uint32_t i = heads[kExpiring];
+        unlink(i);
+        Node &n = nodes[i];
+        if (alignUp(n.expire, n.slackBits) >= current) {
+          place(i); // 被推迟过，还没到期
+        } else if (n.period != 0) {
+          std::function<void()> callback = std::move(n.callback);
+          n.list = kRunning;
+          onExpire(handleOf(i), std::move(callback));
+        } else {
+          std::function<void()> callback = std::move(n.callback);
+          release(i);
+          onExpire(Handle(0), std::move(callback));
+        }
+      }
+      uint64_t next = nextTick();
+      if (next > nowTick) break;
+      current = next;
+      for (int level = 1; level < kLevels; level++) {
+        unsigned shift = kBits * level;
+        if ((current & ((1ull << shift) - 1)) != 0) break;
+        cascade(level, (current >> shift) & (kSlots - 1));
+      }
+      uint16_t slot = static_cast<uint16_t>(current & (kSlots - 1));
+      current++;
+      // 整条链表挪到触发链表上再逐个摘下，回调里取消同一槽位的定时器也能正确处理
+      uint32_t i = heads[slot];
+      if (i == kNil) continue;
+      heads[slot] = kNil;
+      occupied[0] &= ~(1ull << slot);
+      heads[kExpiring] = i;
+      for (; i != kNil; i = nodes[i].next) nodes[i].list = kExpiring;
+    }
+    if (current <= nowTick) current = nowTick + 1;
+  }
+};
+
+// 带索引的二叉小顶堆：定时器节点放在数组里并记录自己在堆中的位置，取消和改期直接定位到堆中的元素，
+// O(log n) 删除或上下调整，回调立即释放，不必等它排到堆顶。句柄与 TimingWheel 相同，为节点下标加代数，
+// 周期定时器也和 TimingWheel 一样交出回调、由 rearm 还回。时间单位由调用方决定
+class TimerHeap {
+public:
+  using Handle = uint64_t;
+
+private:
+  static constexpr uint32_t kNil = UINT32_MAX;
+  // pos 的几种特殊值，含义同 TimingWheel：周期回调执行中、执行期间被取消、执行期间被改期
+  static constexpr uint32_t kRunning = kNil - 1;
+  static constexpr uint32_t kCancelled = kNil - 2;
+  static constexpr uint32_t kMoved = kNil - 3;
+
+  struct Node {
+    uint64_t period = 0; // 0 表示一次性
+    uint64_t expire = 0; // 名义到期时间，周期定时器据此计算下一次；堆里放的是按 slackBits 对齐后的
+    std::function<void()> callback;
+    uint32_t pos = kNil; // 在 heap 中的下标，空闲时为 kNil
+    uint32_t generation = 1;
+    uint32_t nextFree = kNil;
+    RepeatMode mode = RepeatMode::FixedRate;
+    uint8_t slackBits = 0;
+  };
+
+  // 到期时间和节点下标一起放在堆数组里，比较时不用跳到节点上
+  struct Item {
+    uint64_t expire;
+    uint32_t node;
+  };
+
+  std::vector<Node> nodes;
+  std::vector<Item> heap;
+  uint32_t freeList = kNil;
+  size_t count = 0;
+
+  void set(size_t pos, const Item &item) {
+    heap[pos] = item;
+    nodes[item.node].pos = static_cast<uint32_t>(pos);
+  }
+
+  void siftUp(size_t pos) {
+    Item item = heap[pos];
+    while (pos > 0) {
+      size_t parent = (pos - 1) / 2;
+      if (heap[parent].expire <= item.expire) break;
+      set(pos, heap[parent]);
+      pos = parent;
+    }
+    set(pos, item);
+  }
+
+  void siftDown(size_t pos) {
+    Item item = heap[pos];
+    size_t n = heap.size();
+    while (true) {
+      size_t child = 2 * pos + 1;
+      if (child >= n) break;
+      if (child + 1 < n && heap[child + 1].expire < heap[child].expire) child++;
+      if (heap[child].expire >= item.expire) break;
+      set(pos, heap[child]);
+      pos = child;
+    }
+    set(pos, item);
+  }
+
+  void update(size_t pos) {
+    if (pos > 0 && heap[(pos - 1) / 2].expire > heap[pos].expire) siftUp(pos);
+    else siftDown(pos);
+  }
+
+  void erase(size_t pos) {
+    Item last = heap.back();
+    heap.pop_back();
+    if (pos < heap.size()) {
+      set(pos, last);
+      update(pos);
+    }
+  }
+
+  uint32_t find(Handle handle) const {
+    uint32_t i = static_cast<uint32_t>(handle);
+    if (i >= nodes.size() || nodes[i].generation != static_cast<uint32_t>(handle >> 32) ||
+        nodes[i].pos == kNil || nodes[i].pos == kCancelled) {
+      return kNil;
+    }
+    return i;
+  }
+
+  static bool running(uint32_t pos) { return pos == kRunning || pos == kMoved; }
+
+  Handle handleOf(uint32_t i) const {
+    return (static_cast<uint64_t>(nodes[i].generation) << 32) | i;
+  }
+
+  void release(uint32_t i) {
+    Node &n = nodes[i];
+    n.callback = nullptr;
+    n.pos = kNil;
+    n.generation++;
+    n.nextFree = freeList;
+    freeList = i;
+    count--;
+  }
+
+public:
+  TimerHeap() = default;
+  TimerHeap(const TimerHeap &) = delete;
+  TimerHeap &operator=(const TimerHeap &) = delete;
+
+  bool empty() const { return count == 0; }
+  size_t size() const { return count; } // 含回调正在执行的周期定时器
+
+  // 在 expire 时刻触发，period 不为 0 时此后按 mode 每 period 触发一次。
+  // slackBits 不为 0 时每次的到期时间向上对齐到 2^slackBits
+  Handle add(uint64_t expire, std::function<void()> callback, uint64_t period = 0,
+             RepeatMode mode = RepeatMode::FixedRate, unsigned slackBits = 0) {
+    uint32_t i = freeList;
+    if (i != kNil) {
+      freeList = nodes[i].nextFree;
+    } else {
+      i = static_cast<uint32_t>(nodes.size());
+      nodes.emplace_back();
+    }
+    Node &n = nodes[i];
+    n.expire = expire;
+    n.period = period;
+    n.mode = mode;
+    n.slackBits = static_cast<uint8_t>(slackBits);
+    n.callback = std::move(callback);
+    count++;
+    heap.push_back({alignUp(expire, n.slackBits), i});
+    siftUp(heap.size() - 1);
+    return handleOf(i);
+  }
+
+  // 取消尚未触发的定时器，回调立即释放；句柄已经失效时返回 false。
+  // 周期定时器的回调正在执行时先做标记，rearm 时再释放
+  bool cancel(Handle handle) {
+    uint32_t i = find(handle);
+    if (i == kNil) return false;
+    if (running(nodes[i].pos)) {
+      nodes[i].pos = kCancelled;
+      return true;
+    }
+    erase(nodes[i].pos);
+    release(i);
+    return true;
+  }
+
+  // 把定时器（周期定时器为下一次）改到 expire 时刻触发；句柄已经失效时返回 false
+  bool reschedule(Handle handle, uint64_t expire) {
+    uint32_t i = find(handle);
+    if (i == kNil) return false;
+    if (running(nodes[i].pos)) {
+      nodes[i].expire = expire;
+      nodes[i].pos = kMoved;
+      return true;
+    }
+    nodes[i].expire = expire;
+    heap[nodes[i].pos].expire = alignUp(expire, nodes[i].slackBits);
+    update(nodes[i].pos);
+    return true;
+  }
+
+  // 最早的到期时间，没有定时器时返回 UINT64_MAX
+  uint64_t nextTick() const {
+    return heap.empty() ? UINT64_MAX : heap[0].expire;
+  }
+
+  // 周期定时器的回调执行完毕，now 为执行完的时刻：放回回调，按 mode 算出下一次的到期时间重新入堆。
+  // 执行期间被取消的在这里释放并返回 false
+  bool rearm(Handle handle, std::function<void()> &&callback, uint64_t now) {
+    uint32_t i = static_cast<uint32_t>(handle);
+    if (i >= nodes.size() || nodes[i].generation != static_cast<uint32_t>(handle >> 32)) return false;
+    Node &n = nodes[i];
+    if (n.pos == kCancelled) {
+      release(i);
+      return false;
+    }
+    if (!running(n.pos)) return false;
+    if (n.pos == kRunning) n.expire = nextExpire(n.expire, n.period, n.mode, now);
+    n.callback = std::move(callback);
+    heap.push_back({alignUp(n.expire, n.slackBits), i});
+    siftUp(heap.size() - 1);
+    return true;
+  }
+
+  // 对每个到期时间不晚于 now 的定时器调用 onExpire(Handle, std::function<void()>&&)，onExpire 里可以添加或取消定时器。
+  // 一次性定时器的 Handle 为 0；周期定时器出堆，交出回调本身，调用方执行完后必须用 rearm 还回来
+  template <typename OnExpire> void advance(uint64_t now, OnExpire &&onExpire) {
+    while (!heap.empty() && heap[0].expire <= now) {
+      uint32_t i = heap[0].node;
+      Node &n = nodes[i];
+      std::function<void()> callback = std::move(n.callback);
+      if (n.period != 0) {
+        erase(0);
+        n.pos = kRunning;
+        onExpire(handleOf(i), std::move(callback));
+      } else {
+        erase(0);
+        release(i);
+        onExpire(Handle(0), std::move(callback));
+      }
+    }
+  }
+};
+
+// 定时器使用的数据结构：小顶堆 O(log n) 插入和取消；时间轮 O(1)，精度为一个 tick
+enum class TimerBackend { Heap, Wheel };
+
+// 怎么等下一个到期时间：Thread 自带一个线程用条件变量等；Poll 不开线程，最早的到期时间写进一个 timerfd，
+// 调用方把 fd() 和别的 IO 一起放进自己的 epoll/poll 循环，可读时调用 runExpired()
+enum class TimerDriver { Thread, Poll };
+
 class Timer {
 public:
-  // 定时任务结构体
-  struct TimerTask {
-    int id;                                           // 任务ID
-    std::chrono::steady_clock::time_point expireTime; // 到期时间
-    std::function<void()> callback;                   // 回调函数
+  // addTimer/addRepeatingTimer 返回的句柄，定时器到期（周期定时器被取消）后失效，失效的句柄不会误伤别的定时器
+  using TimerId = uint64_t;
+
+  // 一次到期要执行的回调，用 task() 执行。周期定时器的回调执行完（或者没执行就被销毁）时还给 Timer，
+  // 按 RepeatMode 重新排期，所以回调是移进移出的，重复触发不复制、不分配内存
+  class Task {
+  public:
+    Task(Task &&other) noexcept : owner(other.owner), id(other.id), callback(std::move(other.callback)) {
+      other.owner = nullptr;
+    }
 
-    // 比较运算符重载，用于小顶堆
-    bool operator>(const TimerTask &other) const {
-      return expireTime > other.expireTime;
+    Task &operator=(Task &&other) noexcept {
+      if (this != &other) {
+        giveBack();
+        owner = other.owner;
+        id = other.id;
+        callback = std::move(other.callback);
+        other.owner = nullptr;
+      }
+      return *this;
+    }
+
+    ~Task() { giveBack(); }
+
+    void operator()() {
+      callback();
+      giveBack();
+    }
+
+  private:
+    friend class Timer;
+
+    Timer *owner; // 一次性定时器为 nullptr
+    TimerId id;
+    std::function<void()> callback;
+
+    Task(Timer *owner, TimerId id, std::function<void()> &&callback)
+        : owner(owner), id(id), callback(std::move(callback)) {}
+
+    void giveBack() {
+      if (owner == nullptr) return;
+      Timer *timer = owner;
+      owner = nullptr;
+      timer->finish(id, std::move(callback));
     }
   };
 
+  // 一批到期的回调，以及执行它们的执行器
+  using Batch = std::vector<Task>;
+  using Executor = std::function<void(Batch &&)>;
+
 private:
-  // 使用优先队列（小顶堆）存储定时任务
-  std::priority_queue<TimerTask, std::vector<TimerTask>,
-                      std::greater<TimerTask>>
-      timerQueue;
+  TimerBackend backend;
+  // 两种结构都以 epoch 起算的 tick 计时；小顶堆的 tick 就是 steady_clock 的最小单位
+  std::chrono::steady_clock::time_point epoch;
+  std::chrono::steady_clock::duration tick;
+  TimerHeap heap;
+  TimingWheel wheel;
   std::mutex mutex;
   std::condition_variable cv;
   std::atomic<bool> running{true};
+  std::shared_ptr<const Executor> executor; // 为空时在定时器线程上直接执行
+  size_t batchSize = 0;
+  size_t inFlight = 0;          // 已经交出、还没还回来的周期回调
+  // 定时器线程睡到（Poll 时 timerfd 设在）哪个 tick，醒着或正在 runExpired 时为 0，没有定时器时为 UINT64_MAX
+  uint64_t sleepingUntil = 0;
+  uint64_t wakeups = 0;
+  int timerFd = -1; // 只有 Poll 使用
+  Batch expired;    // 处理线程（Poll 时为调用 runExpired 的线程）取出的到期回调，跨轮复用
   std::thread timerThread;
-  int nextTaskId{0};
+
+  uint64_t tickOf(std::chrono::steady_clock::time_point t) const {
+    return static_cast<uint64_t>((t - epoch) / tick);
+  }
+
+  // 延迟换算成到期 tick，向上取整，回调不会提前执行
+  uint64_t deadlineAfter(int delayMs) const {
+    auto expireTime = std::chrono::steady_clock::now() + std::chrono::milliseconds(std::max(delayMs, 0));
+    return tickOf(expireTime + tick - std::chrono::steady_clock::duration(1));
+  }
+
+  uint64_t ticksOf(int intervalMs) const {
+    auto interval = std::chrono::steady_clock::duration(std::chrono::milliseconds(intervalMs));
+    return std::max<uint64_t>((interval + tick - std::chrono::steady_clock::duration(1)) / tick, 1);
+  }
+
+  // 允许的误差换算成对齐位数：不超过 slackMs 的最大的 2 的幂个 tick
+  unsigned slackBitsOf(int slackMs) const {
+    if (slackMs <= 0) return 0;
+    uint64_t ticks = static_cast<uint64_t>(std::chrono::steady_clock::duration(std::chrono::milliseconds(slackMs)) / tick);
+    return ticks == 0 ? 0 : 63 - __builtin_clzll(ticks);
+  }
+
+  // 对当前使用的数据结构执行 f，两者接口相同
+  template <typename F> decltype(auto) withQueue(F &&f) {
+    if (backend == TimerBackend::Wheel) return f(wheel);
+    return f(heap);
+  }
+
+  // timerfd 定在第 next 个 tick 到期；steady_clock 在 Linux 上就是 CLOCK_MONOTONIC，直接用绝对时间
+  void armTimerFd(uint64_t next) {
+    itimerspec spec{};
+    if (next != UINT64_MAX) {
+      auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>((epoch + tick * next).time_since_epoch()).count();
+      if (ns <= 0) ns = 1; // 全 0 表示停掉 timerfd
+      spec.it_value.tv_sec = static_cast<time_t>(ns / 1000000000);
+      spec.it_value.tv_nsec = static_cast<long>(ns % 1000000000);
+    }
+    ::timerfd_settime(timerFd, TFD_TIMER_ABSTIME, &spec, nullptr);
+    sleepingUntil = next;
+  }
+
+  // 队列变化后（持有锁时调用）：最早的到期时间早于现在等待的时刻才唤醒定时器线程或改 timerfd，
+  // 大多数添加和每次周期定时器重新排期都不用打扰等待的一方
+  void wakeIfEarlier() {
+    uint64_t next = withQueue([](auto &queue) { return queue.nextTick(); });
+    if (next >= sleepingUntil) return;
+    if (timerFd >= 0) armTimerFd(next);
+    else cv.notify_one();
+  }
 
 public:
-  Timer() {
+  // tick 只对时间轮有效：到期时间向上取整到 tick，回调最多晚一个 tick 执行
+  explicit Timer(TimerBackend backend = TimerBackend::Heap,
+                 std::chrono::milliseconds tick = std::chrono::milliseconds(1),
+                 TimerDriver driver = TimerDriver::Thread)
+      : backend(backend), epoch(std::chrono::steady_clock::now()),
+        tick(backend == TimerBackend::Wheel
+                 ? std::max(std::chrono::steady_clock::duration(tick), std::chrono::steady_clock::duration(1))
+                 : std::chrono::steady_clock::duration(1)) {
+    if (driver == TimerDriver::Poll) {
+      timerFd = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+      if (timerFd < 0) throw std::runtime_error("timerfd_create failed");
+      sleepingUntil = UINT64_MAX;
+      return;
+    }
     // 启动定时器线程
     timerThread = std::thread([this]() { this->processTimerTasks(); });
   }
 
   ~Timer() {
     // 停止定时器线程
-    running = false;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      running = false;
+    }
     cv.notify_one();
     if (timerThread.joinable()) {
       timerThread.join();
     }
+    // 交给执行器的周期回调执行完还要回到 Timer，等它们都回来
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [this] { return inFlight == 0; });
+    if (timerFd >= 0) ::close(timerFd);
+  }
+
+  // 添加定时任务（延迟执行）。slackMs 是允许晚触发的毫秒数，相近的定时器会合并到一次唤醒里
+  TimerId addTimer(int delayMs, std::function<void()> callback, int slackMs = 0) {
+    std::lock_guard<std::mutex> lock(mutex);
+    TimerId id = withQueue([&](auto &queue) {
+      return queue.add(deadlineAfter(delayMs), std::move(callback), 0, RepeatMode::FixedRate, slackBitsOf(slackMs));
+    });
+    wakeIfEarlier(); // 通知处理线程
+    return id;
   }
 
-  // 添加定时任务（延迟执行）
-  int addTimer(int delayMs, std::function<void()> callback) {
+  // 添加周期性定时任务：intervalMs 后第一次触发，之后按 mode 每 intervalMs 触发一次，句柄在取消前一直有效。
+  // 回调执行完才排下一次，同一个周期定时器不会并发执行。slackMs 同 addTimer，只影响每次触发的时刻，不累积
+  TimerId addRepeatingTimer(int intervalMs, std::function<void()> callback,
+                            RepeatMode mode = RepeatMode::FixedRate, int slackMs = 0) {
     std::lock_guard<std::mutex> lock(mutex);
-    int taskId = nextTaskId++;
+    TimerId id = withQueue([&](auto &queue) {
+      return queue.add(deadlineAfter(intervalMs), std::move(callback), ticksOf(intervalMs), mode,
+                       slackBitsOf(slackMs));
+    });
+    wakeIfEarlier();
+    return id;
+  }
+
+  // TimerDriver::Poll 时的 timerfd，可读表示有定时器到期，Thread 时为 -1
+  int fd() const { return timerFd; }
+
+  // TimerDriver::Poll 时在 fd() 可读后调用（同一时刻只能有一个线程调用）：执行或交给执行器所有到期的回调，
+  // 再把 timerfd 定到下一个到期时间。返回这一轮到期的回调个数
+  size_t runExpired() {
+    uint64_t expirations;
+    while (::read(timerFd, &expirations, sizeof(expirations)) > 0) {
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    wakeups++;
+    sleepingUntil = 0;
+    size_t n = dispatchExpired(lock);
+    if (!lock.owns_lock()) lock.lock();
+    armTimerFd(withQueue([](auto &queue) { return queue.nextTick(); }));
+    return n;
+  }
 
-    auto expireTime =
-        std::chrono::steady_clock::now() + std::chrono::milliseconds(delayMs);
+  // 定时器线程醒来（Poll 时为 runExpired 被调用）的次数
+  uint64_t wakeupCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return wakeups;
+  }
 
-    timerQueue.push({taskId, expireTime, std::move(callback)});
-    cv.notify_one(); // 通知处理线程
-    return taskId;
+  // 到期的回调改由 exec 执行，定时器线程只负责计时：每轮到期的回调按 batchSize 个一批交给 exec，
+  // 一个慢回调不再拖住排在后面的定时器。exec 可以随时更换，传空恢复在定时器线程上执行。
+  // 交出去的回调可能并发执行。exec 及其背后的线程池要比 Timer 活得久，每个 Task 最终都要执行或销毁：
+  // Timer 析构时会等周期定时器的 Task 回来，一次性定时器的则不等
+  void setExecutor(Executor exec, size_t batchSize = 16) {
+    std::lock_guard<std::mutex> lock(mutex);
+    executor = exec ? std::make_shared<const Executor>(std::move(exec)) : nullptr;
+    this->batchSize = std::max<size_t>(batchSize, 1);
   }
 
-  // 添加周期性定时任务
-  void addRepeatingTimer(int intervalMs, std::function<void()> callback) {
-    std::function<void()> repeatingCallback;
-    repeatingCallback = [=]() {
-      callback();                              // 执行回调
-      addTimer(intervalMs, repeatingCallback); // 添加下一次执行
-    };
+  // 取消定时器并立即释放回调，定时器已经到期或句柄无效时返回 false。
+  // 已经交给处理线程、正在执行的那一次回调不受影响
+  bool cancel(TimerId id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return withQueue([&](auto &queue) { return queue.cancel(id); });
+  }
 
-    addTimer(intervalMs, repeatingCallback);
+  // 把定时器改为从现在起 newDelayMs 后触发（周期定时器改的是下一次，之后仍按原周期）
+  bool reschedule(TimerId id, int newDelayMs) {
+    std::lock_guard<std::mutex> lock(mutex);
+    bool found = withQueue([&](auto &queue) { return queue.reschedule(id, deadlineAfter(newDelayMs)); });
+    if (found) wakeIfEarlier(); // 可能提前了
+    return found;
   }
 
 private:
+  // 周期定时器的 Task 执行完毕，把回调还给队列重新排期
+  void finish(TimerId id, std::function<void()> &&callback) {
+    uint64_t now = tickOf(std::chrono::steady_clock::now());
+    std::lock_guard<std::mutex> lock(mutex);
+    withQueue([&](auto &queue) { queue.rearm(id, std::move(callback), now); });
+    inFlight--;
+    if (!running) {
+      if (inFlight == 0) cv.notify_all();
+    } else {
+      wakeIfEarlier();
+    }
+  }
+
+  // 在定时器线程上执行一批回调，其中的周期定时器执行完后一次加锁全部重新排期
+  void runInline(Batch &expired, std::unique_lock<std::mutex> &lock) {
+    for (Task &task : expired) task.callback(); // 执行回调函数
+    uint64_t now = tickOf(std::chrono::steady_clock::now());
+    lock.lock();
+    withQueue([&](auto &queue) {
+      for (Task &task : expired) {
+        if (task.owner == nullptr) continue;
+        queue.rearm(task.id, std::move(task.callback), now);
+        task.owner = nullptr;
+        inFlight--;
+      }
+    });
+    lock.unlock();
+  }
+
+  // 一次取出所有到期的回调，解锁后依次执行或分批交给执行器，返回回调个数。
+  // 调用时持有锁，有回调时返回前已经解锁
+  size_t dispatchExpired(std::unique_lock<std::mutex> &lock) {
+    withQueue([&](auto &queue) {
+      queue.advance(tickOf(std::chrono::steady_clock::now()), [&](TimerId id, std::function<void()> &&callback) {
+        expired.push_back(Task(id != 0 ? this : nullptr, id, std::move(callback)));
+        if (id != 0) inFlight++;
+      });
+    });
+    size_t n = expired.size();
+    if (n == 0) return 0;
+    std::shared_ptr<const Executor> exec = executor;
+    size_t perBatch = batchSize;
+    lock.unlock();
+    if (!exec) {
+      runInline(expired, lock);
+    } else if (n <= perBatch) {
+      (*exec)(std::move(expired));
+    } else {
+      for (size_t i = 0; i < n; i += perBatch) {
+        size_t end = std::min(i + perBatch, n);
+        (*exec)(Batch(std::make_move_iterator(expired.begin() + i), std::make_move_iterator(expired.begin() + end)));
+      }
+    }
+    expired.clear();
+    return n;
+  }
+
   // 定时器处理线程的主循环
   void processTimerTasks() {
-    while (running) {
+    while (true) {
       std::unique_lock<std::mutex> lock(mutex);
-
-      if (timerQueue.empty()) {
+      // running 要在锁内检查：析构在这之前改写并通知时，这里看得到；之后改写时通知一定在 wait 之后
+      if (!running) break;
+      if (dispatchExpired(lock) > 0) continue;
+      uint64_t next = withQueue([](auto &queue) { return queue.nextTick(); });
+      sleepingUntil = next;
+      if (next == UINT64_MAX) {
         // 如果没有任务，等待新任务
         cv.wait(lock);
-        continue;
+      } else {
+        // 等待到下一个任务的时间
+        cv.wait_until(lock, epoch + tick * next);
       }
+      sleepingUntil = 0;
+      wakeups++;
+    }
+  }
+};
 
-      auto &nextTask = timerQueue.top();
-      auto now = std::chrono::steady_clock::now();
+// 把每批回调作为一个任务提交给线程池，Pool 需要提供 enqueue(f)，例如 线程池.cpp 里的 ThreadPool
+template <typename Pool> Timer::Executor poolExecutor(Pool &pool) {
+  return [&pool](Timer::Batch &&batch) {
+    pool.enqueue([batch = std::move(batch)]() mutable {
+      for (Timer::Task &task : batch) task();
+    });
+  };
+}
 
-      if (nextTask.expireTime <= now) {
-        // 任务到期，执行回调
-        auto callback = std::move(nextTask.callback);
-        timerQueue.pop();
-        lock.unlock();
+// 分片定时器到期时怎么处理：每个分片一个定时器线程；或者分片都用 timerfd，
+// 由一个线程 epoll 等所有分片的 fd，最早的到期时间由内核取，不需要跨分片的锁
+enum class ShardExpiry { PerShardThread, MergedEpoll };
 
-        callback(); // 执行回调函数
-      } else {
-        // 等待到下一个任务的时间
-        cv.wait_until(lock, nextTask.expireTime);
+// 分片定时器：每个分片是一个独立的 Timer（自己的锁和队列），线程第一次添加定时器时分到一个固定的分片，
+// 之后都加到这个分片里，线程数不超过分片数时添加和取消不会和别的线程抢同一把锁。
+// 句柄记着分片号，在别的线程上取消和改期也能找到原分片
+class ShardedTimer {
+public:
+  struct TimerId {
+    uint32_t shard;
+    Timer::TimerId id;
+  };
+
+private:
+  std::vector<std::unique_ptr<Timer>> shards;
+  int epollFd = -1;
+  int stopFd = -1; // eventfd，析构时通知 epoll 线程退出
+  std::thread expiryThread;
+
+  // 线程的槽位号在第一次使用时按顺序分配，同一个线程在不同的 ShardedTimer 里用同一个槽位号
+  uint32_t localShard() const {
+    static std::atomic<uint32_t> nextSlot{0};
+    thread_local uint32_t slot = nextSlot.fetch_add(1, std::memory_order_relaxed);
+    return slot % static_cast<uint32_t>(shards.size());
+  }
+
+  void runMerged() {
+    std::vector<epoll_event> events(shards.size() + 1);
+    while (true) {
+      int n = ::epoll_wait(epollFd, events.data(), static_cast<int>(events.size()), -1);
+      for (int i = 0; i < n; i++) {
+        if (events[i].data.u32 == shards.size()) return;
+        shards[events[i].data.u32]->runExpired();
       }
     }
   }
+
+public:
+  // shardCount 一般取添加定时器的线程数；MergedEpoll 时所有分片的回调都在同一个线程上执行（除非设置了执行器）
+  explicit ShardedTimer(size_t shardCount = std::thread::hardware_concurrency(),
+                        ShardExpiry expiry = ShardExpiry::PerShardThread,
+                        TimerBackend backend = TimerBackend::Wheel,
+                        std::chrono::milliseconds tick = std::chrono::milliseconds(1)) {
+    shardCount = std::max<size_t>(shardCount, 1);
+    TimerDriver driver = expiry == ShardExpiry::MergedEpoll ? TimerDriver::Poll : TimerDriver::Thread;
+    for (size_t i = 0; i < shardCount; i++) shards.push_back(std::make_unique<Timer>(backend, tick, driver));
+    if (expiry == ShardExpiry::PerShardThread) return;
+    epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+    stopFd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (epollFd < 0 || stopFd < 0) {
+      if (epollFd >= 0) ::close(epollFd);
+      if (stopFd >= 0) ::close(stopFd);
+      throw std::runtime_error("cannot create epoll for ShardedTimer");
+    }
+    for (uint32_t i = 0; i <= shardCount; i++) {
+      epoll_event ev{};
+      ev.events = EPOLLIN;
+      ev.data.u32 = i;
+      ::epoll_ctl(epollFd, EPOLL_CTL_ADD, i < shardCount ? shards[i]->fd() : stopFd, &ev);
+    }
+    expiryThread = std::thread([this]() { this->runMerged(); });
+  }
+
+  ~ShardedTimer() {
+    if (expiryThread.joinable()) {
+      uint64_t one = 1;
+      ::write(stopFd, &one, sizeof(one));
+      expiryThread.join();
+    }
+    shards.clear();
+    if (epollFd >= 0) ::close(epollFd);
+    if (stopFd >= 0) ::close(stopFd);
+  }
+
+  ShardedTimer(const ShardedTimer &) = delete;
+  ShardedTimer &operator=(const ShardedTimer &) = delete;
+
+  size_t shardCount() const { return shards.size(); }
+
+  TimerId addTimer(int delayMs, std::function<void()> callback, int slackMs = 0) {
+    uint32_t shard = localShard();
+    return {shard, shards[shard]->addTimer(delayMs, std::move(callback), slackMs)};
+  }
+
+  TimerId addRepeatingTimer(int intervalMs, std::function<void()> callback,
+                            RepeatMode mode = RepeatMode::FixedRate, int slackMs = 0) {
+    uint32_t shard = localShard();
+    return {shard, shards[shard]->addRepeatingTimer(intervalMs, std::move(callback), mode, slackMs)};
+  }
+
+  bool cancel(TimerId id) { return shards[id.shard]->cancel(id.id); }
+
+  bool reschedule(TimerId id, int newDelayMs) { return shards[id.shard]->reschedule(id.id, newDelayMs); }
+
+  // 所有分片共用一个执行器
+  void setExecutor(const Timer::Executor &exec, size_t batchSize = 16) {
+    for (auto &shard : shards) shard->setExecutor(exec, batchSize);
+  }
+
+  uint64_t wakeupCount() {
+    uint64_t total = 0;
+    for (auto &shard : shards) total += shard->wakeupCount();
+    return total;
+  }
 };
 
-// 使用示例
-int main() {
+#ifndef NO_MAIN
+#define NO_MAIN
+#include "线程池.cpp"
+#undef NO_MAIN
+
+#include <sys/resource.h>
+
+// 大块内存由 mmap 分配，计入 hblkhd 而不是 uordblks
+size_t heapBytes() {
+  struct mallinfo2 mi = mallinfo2();
+  return mi.uordblks + mi.hblkhd;
+}
+
+// 统计 new 的次数，用来看周期定时器每触发一次分配几次内存
+std::atomic<size_t> allocations{0};
+
+void *operator new(size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void *p = std::malloc(size == 0 ? 1 : size)) return p;
+  throw std::bad_alloc();
+}
+
+// 不内联：GCC 内联后会把 free 和调用方看到的 new 配对，误报 -Wmismatched-new-delete
+[[gnu::noinline]] void operator delete(void *p) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+// 对一种数据结构依次计时：添加 n 个定时器，把一半推迟（相当于续期 keepalive），取消 90%，再一路推进到全部到期
+template <typename Queue>
+void benchmarkEngine(const char *name, const std::vector<uint64_t> &delays, const std::vector<size_t> &order,
+                     uint64_t span) {
+  size_t n = delays.size();
+  size_t cancels = n - n / 10;
+  auto secs = [](auto start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  };
+  size_t before = heapBytes();
+  Queue queue;
+  std::vector<typename Queue::Handle> handles(n);
+  size_t fired = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < n; i++) handles[i] = queue.add(delays[i], [&fired] { fired++; });
+  double addSecs = secs(start);
+  size_t bytes = heapBytes() - before - n * sizeof(typename Queue::Handle);
+  start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < n; i += 2) queue.reschedule(handles[order[i]], delays[order[i]] + span / 2);
+  double rescheduleSecs = secs(start);
+  start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < cancels; i++) queue.cancel(handles[order[i]]);
+  double cancelSecs = secs(start);
+  start = std::chrono::steady_clock::now();
+  queue.advance(2 * span, [](typename Queue::Handle, std::function<void()> &&callback) { callback(); });
+  double drainSecs = secs(start);
+  std::cout << "  " << name << " add " << addSecs * 1e9 / n << " ns, reschedule " << rescheduleSecs * 1e9 / (n / 2)
+            << " ns, cancel " << cancelSecs * 1e9 / cancels << " ns, expire " << drainSecs * 1000 << " ms, fired "
+            << fired << ", " << bytes / n << " B/timer" << std::endl;
+}
+
+// 引擎对比（单线程，不含加锁和等待）：n 个定时器到期时间均匀分布在 1..span 个 tick 之后。
+// 最后一行是改造前的做法：std::priority_queue 不能删除中间元素，取消只能记一个标记，
+// 被取消的任务和它的回调留在堆里，直到排到堆顶才被丢弃
+void benchmarkEngines(size_t n, uint64_t span) {
+  std::mt19937_64 rng(42);
+  std::vector<uint64_t> delays(n);
+  for (auto &d : delays) d = 1 + rng() % span;
+  std::vector<size_t> order(n);
+  for (size_t i = 0; i < n; i++) order[i] = i;
+  std::shuffle(order.begin(), order.end(), rng);
+  size_t cancels = n - n / 10;
+  std::cout << "n=" << n << " span=" << span << " ticks, reschedule " << n / 2 << ", cancel " << cancels << std::endl;
+
+  benchmarkEngine<TimingWheel>("wheel:        ", delays, order, span);
+  benchmarkEngine<TimerHeap>("indexed heap: ", delays, order, span);
+
+  struct Task {
+    uint64_t expire;
+    size_t id;
+    std::function<void()> callback;
+    bool operator>(const Task &other) const { return expire > other.expire; }
+  };
+  size_t before = heapBytes();
+  std::priority_queue<Task, std::vector<Task>, std::greater<Task>> heap;
+  std::vector<char> cancelled(n, 0);
+  size_t fired = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < n; i++) heap.push({delays[i], i, [&fired] { fired++; }});
+  double addSecs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  size_t bytes = heapBytes() - before - n;
+  for (size_t i = 0; i < cancels; i++) cancelled[order[i]] = 1;
+  start = std::chrono::steady_clock::now();
+  while (!heap.empty()) {
+    if (!cancelled[heap.top().id]) heap.top().callback();
+    heap.pop();
+  }
+  double drainSecs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::cout << "  priority_queue + flag: add " << addSecs * 1e9 / n << " ns, no reschedule, expire "
+            << drainSecs * 1000 << " ms, fired " << fired << ", " << bytes / n << " B/timer" << std::endl;
+}
+
+// 到期延迟（回调开始执行的时间减去应当到期的时间）的分布：n 个定时器的到期时间均匀分布在 span 毫秒内，
+// 其中 slowPercent% 的回调要睡 slowMs 毫秒（模拟同步 IO），executor 为空时所有回调都在定时器线程上执行
+void benchmarkLateness(const char *name, size_t n, int span, int slowPercent, int slowMs, Timer::Executor executor,
+                       size_t batchSize = 16) {
+  std::mt19937 rng(7);
+  std::vector<int64_t> lateness(n);
+  std::atomic<size_t> done{0};
+  auto start = std::chrono::steady_clock::now();
+  {
+    Timer timer;
+    timer.setExecutor(std::move(executor), batchSize);
+    for (size_t i = 0; i < n; i++) {
+      int delay = 1 + static_cast<int>(rng() % span);
+      bool slow = static_cast<int>(rng() % 100) < slowPercent;
+      auto due = start + std::chrono::milliseconds(delay);
+      timer.addTimer(delay, [&, i, due, slow, slowMs]() {
+        lateness[i] = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - due).count();
+        if (slow) std::this_thread::sleep_for(std::chrono::milliseconds(slowMs));
+        done++;
+      });
+    }
+    while (done < n) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  std::sort(lateness.begin(), lateness.end());
+  auto pct = [&](double p) { return lateness[std::min(n - 1, static_cast<size_t>(p * n))] / 1000.0; };
+  std::cout << "  " << name << " p50 " << pct(0.5) << " ms, p90 " << pct(0.9) << " ms, p99 " << pct(0.99)
+            << " ms, p99.9 " << pct(0.999) << " ms, max " << lateness.back() / 1000.0 << " ms" << std::endl;
+}
+
+void benchmarkLatenessAll() {
+  const size_t n = 5000;
+  const int span = 5000, slowPercent = 2, slowMs = 20;
+  std::cout << n << " timers over " << span << " ms, " << slowPercent << "% of callbacks block for " << slowMs
+            << " ms" << std::endl;
+  benchmarkLateness("timer thread:          ", n, span, slowPercent, slowMs, nullptr);
+  ThreadPool pool(8); // 要比 Timer 活得久
+  benchmarkLateness("ThreadPool(8), batch 16:", n, span, slowPercent, slowMs, poolExecutor(pool));
+  benchmarkLateness("ThreadPool(8), batch 1: ", n, span, slowPercent, slowMs, poolExecutor(pool), 1);
+}
+
+// 改造前的周期定时器：回调里用 addTimer 把自己再加一次，每个周期都从执行时的“现在”起算，
+// 每次都要复制整个可调用对象（std::function 放不下，要分配内存）并再走一遍加锁
+struct SelfRearming {
+  Timer *timer;
+  int intervalMs;
+  std::function<void()> callback;
+  void operator()() const {
+    callback();
+    timer->addTimer(intervalMs, *this);
+  }
+};
+
+// n 个周期为 periodMs 的定时器跑 seconds 秒（回调只计数，inline 执行）：
+// 触发次数占按时间表应有次数的比例、每次触发耗费的 CPU 时间和内存分配次数。
+// mode 为空指针时测改造前的自我重加
+void benchmarkRepeating(const char *name, TimerBackend backend, const RepeatMode *mode, size_t n, int periodMs,
+                        int seconds) {
+  std::vector<uint32_t> fires(n, 0);
+  size_t ideal = n * static_cast<size_t>(seconds * 1000 / periodMs);
+  size_t total = 0, allocs = 0;
+  double cpuSecs = 0;
+  {
+    Timer timer(backend);
+    for (size_t i = 0; i < n; i++) {
+      uint32_t *counter = &fires[i];
+      std::function<void()> callback = [counter] { ++*counter; };
+      if (mode != nullptr) timer.addRepeatingTimer(periodMs, std::move(callback), *mode);
+      else timer.addTimer(periodMs, SelfRearming{&timer, periodMs, std::move(callback)});
+    }
+    size_t allocsBefore = allocations.load();
+    std::clock_t cpuBefore = std::clock();
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    cpuSecs = static_cast<double>(std::clock() - cpuBefore) / CLOCKS_PER_SEC;
+    allocs = allocations.load() - allocsBefore;
+    for (uint32_t f : fires) total += f; // 定时器线程还在跑，只是个近似值
+  }
+  std::cout << "  " << name << " " << total << " fires (" << 100.0 * total / ideal << "% of schedule), CPU "
+            << cpuSecs * 1e9 / total << " ns/fire (" << 100 * cpuSecs / seconds << "% of a core), "
+            << static_cast<double>(allocs) / total << " allocs/fire" << std::endl;
+}
+
+// 一个 10ms 的周期定时器，第 3 次回调阻塞 35ms，打印前 8 次触发的时刻，看三种模式怎么补上错过的周期
+void showCatchUp(const char *name, TimerBackend backend, RepeatMode mode) {
+  std::vector<long> at;
+  auto start = std::chrono::steady_clock::now();
+  {
+    Timer timer(backend);
+    timer.addRepeatingTimer(10, [&]() {
+      if (at.size() >= 8) return;
+      at.push_back(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count());
+      if (at.size() == 3) std::this_thread::sleep_for(std::chrono::milliseconds(35));
+    }, mode);
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+  }
+  std::cout << "  " << name;
+  for (long ms : at) std::cout << " " << ms;
+  std::cout << " ms" << std::endl;
+}
+
+void benchmarkRepeatingAll() {
+  const size_t n = 100000;
+  const int periodMs = 10, seconds = 3;
+  std::cout << n << " repeating timers every " << periodMs << " ms for " << seconds << " s" << std::endl;
+  RepeatMode fixedRate = RepeatMode::FixedRate;
+  benchmarkRepeating("self re-add (old), heap:", TimerBackend::Heap, nullptr, n, periodMs, seconds);
+  benchmarkRepeating("FixedRate, heap:        ", TimerBackend::Heap, &fixedRate, n, periodMs, seconds);
+  benchmarkRepeating("self re-add (old), wheel:", TimerBackend::Wheel, nullptr, n, periodMs, seconds);
+  benchmarkRepeating("FixedRate, wheel:        ", TimerBackend::Wheel, &fixedRate, n, periodMs, seconds);
+  std::cout << "catch-up after one 35 ms stall (fire times):" << std::endl;
+  showCatchUp("FixedRate, heap:     ", TimerBackend::Heap, RepeatMode::FixedRate);
+  showCatchUp("FixedRateSkip, heap: ", TimerBackend::Heap, RepeatMode::FixedRateSkip);
+  showCatchUp("FixedDelay, heap:    ", TimerBackend::Heap, RepeatMode::FixedDelay);
+  showCatchUp("FixedRate, wheel:    ", TimerBackend::Wheel, RepeatMode::FixedRate);
+  showCatchUp("FixedRateSkip, wheel:", TimerBackend::Wheel, RepeatMode::FixedRateSkip);
+  showCatchUp("FixedDelay, wheel:   ", TimerBackend::Wheel, RepeatMode::FixedDelay);
+}
+
+// n 个低精度的周期定时器（周期均匀分布在 0.5~1.5 秒，例如心跳和空闲检查），允许 slackMs 的误差：
+// 稳定运行 seconds 秒内每秒唤醒几次、占多少 CPU。Poll 时由一个 epoll 循环等 timerfd
+void benchmarkCoalescing(const char *name, TimerBackend backend, TimerDriver driver, int slackMs, size_t n,
+                         int seconds) {
+  std::mt19937 rng(3);
+  std::atomic<size_t> fires{0};
+  Timer timer(backend, std::chrono::milliseconds(1), driver);
+  for (size_t i = 0; i < n; i++) {
+    timer.addRepeatingTimer(500 + static_cast<int>(rng() % 1000), [&fires] { fires.fetch_add(1, std::memory_order_relaxed); },
+                            RepeatMode::FixedRate, slackMs);
+  }
+  std::atomic<bool> stop{false};
+  std::thread loop;
+  if (driver == TimerDriver::Poll) {
+    loop = std::thread([&] {
+      int ep = ::epoll_create1(EPOLL_CLOEXEC);
+      epoll_event ev{};
+      ev.events = EPOLLIN;
+      ::epoll_ctl(ep, EPOLL_CTL_ADD, timer.fd(), &ev);
+      while (!stop) {
+        if (::epoll_wait(ep, &ev, 1, 100) > 0) timer.runExpired();
+      }
+      ::close(ep);
+    });
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(1500)); // 等第一次触发铺开
+  uint64_t wakeupsBefore = timer.wakeupCount();
+  size_t firesBefore = fires;
+  std::clock_t cpuBefore = std::clock();
+  std::this_thread::sleep_for(std::chrono::seconds(seconds));
+  double cpuSecs = static_cast<double>(std::clock() - cpuBefore) / CLOCKS_PER_SEC;
+  uint64_t wakeups = timer.wakeupCount() - wakeupsBefore;
+  size_t fired = fires - firesBefore;
+  stop = true;
+  if (loop.joinable()) loop.join();
+  std::cout << "  " << name << " " << wakeups / seconds << " wakeups/s, " << fired / seconds << " fires/s, "
+            << static_cast<double>(fired) / std::max<uint64_t>(wakeups, 1) << " fires/wakeup, CPU "
+            << 100 * cpuSecs / seconds << "% of a core" << std::endl;
+}
+
+void benchmarkCoalescingAll() {
+  const size_t n = 100000;
+  const int seconds = 3;
+  std::cout << n << " repeating timers, periods 0.5-1.5 s" << std::endl;
+  benchmarkCoalescing("heap,  thread, slack 0:    ", TimerBackend::Heap, TimerDriver::Thread, 0, n, seconds);
+  benchmarkCoalescing("heap,  thread, slack 10ms: ", TimerBackend::Heap, TimerDriver::Thread, 10, n, seconds);
+  benchmarkCoalescing("heap,  timerfd, slack 0:   ", TimerBackend::Heap, TimerDriver::Poll, 0, n, seconds);
+  benchmarkCoalescing("heap,  timerfd, slack 10ms:", TimerBackend::Heap, TimerDriver::Poll, 10, n, seconds);
+  benchmarkCoalescing("heap,  timerfd, slack 100ms:", TimerBackend::Heap, TimerDriver::Poll, 100, n, seconds);
+  benchmarkCoalescing("wheel, timerfd, slack 0:   ", TimerBackend::Wheel, TimerDriver::Poll, 0, n, seconds);
+  benchmarkCoalescing("wheel, timerfd, slack 10ms:", TimerBackend::Wheel, TimerDriver::Poll, 10, n, seconds);
+}
+
+// 多个线程同时添加和取消：每个线程循环添加一个 1~60 秒后到期的定时器（相当于给请求设超时），
+// 九成随后被取消（响应到了），返回每秒完成的添加加取消次数。
+// switches 为期间进程的主动上下文切换次数，线程抢锁失败睡在 futex 上会计入这里
+template <typename T> double producerThroughput(T &timer, size_t threads, size_t opsPerThread, long &switches) {
+  std::vector<std::thread> producers;
+  rusage before, after;
+  ::getrusage(RUSAGE_SELF, &before);
+  auto start = std::chrono::steady_clock::now();
+  for (size_t t = 0; t < threads; t++) {
+    producers.emplace_back([&timer, t, opsPerThread] {
+      std::mt19937 rng(static_cast<unsigned>(t));
+      for (size_t i = 0; i < opsPerThread; i++) {
+        auto id = timer.addTimer(1000 + static_cast<int>(rng() % 59000), [] {});
+        if (i % 10 != 0) timer.cancel(id);
+      }
+    });
+  }
+  for (auto &producer : producers) producer.join();
+  double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  ::getrusage(RUSAGE_SELF, &after);
+  switches = after.ru_nvcsw - before.ru_nvcsw;
+  size_t ops = threads * (opsPerThread + opsPerThread - (opsPerThread + 9) / 10);
+  return ops / secs;
+}
+
+void benchmarkProducers() {
+  const size_t total = 2000000;
+  std::cout << "add + cancel throughput, wheel backend, " << total << " adds split across producer threads ("
+            << std::thread::hardware_concurrency() << " cores)" << std::endl;
+  for (size_t threads : {1, 4, 16, 64}) {
+    size_t perThread = total / threads;
+    double single, perShard, merged;
+    long singleSwitches, perShardSwitches, mergedSwitches;
+    {
+      Timer timer(TimerBackend::Wheel);
+      single = producerThroughput(timer, threads, perThread, singleSwitches);
+    }
+    {
+      ShardedTimer timer(threads, ShardExpiry::PerShardThread);
+      perShard = producerThroughput(timer, threads, perThread, perShardSwitches);
+    }
+    {
+      ShardedTimer timer(threads, ShardExpiry::MergedEpoll);
+      merged = producerThroughput(timer, threads, perThread, mergedSwitches);
+    }
+    std::cout << "  " << threads << " threads: one Timer " << single / 1e6 << " M ops/s (" << singleSwitches
+              << " blocking switches), sharded, thread per shard " << perShard / 1e6 << " M ops/s ("
+              << perShardSwitches << "), sharded, merged epoll " << merged / 1e6 << " M ops/s (" << mergedSwitches
+              << ")" << std::endl;
+  }
+}
+
+// 使用示例；带参数 bench 时运行引擎对比，lateness 测回调阻塞时的到期延迟，repeat 测周期定时器，
+// coalesce 测 slack 合并唤醒，producers 测多线程添加和取消的吞吐
+int main(int argc, char **argv) {
+  if (argc > 1 && std::string(argv[1]) == "bench") {
+    for (size_t n : {1000000, 10000000}) benchmarkEngines(n, 60000);
+    return 0;
+  }
+  if (argc > 1 && std::string(argv[1]) == "lateness") {
+    benchmarkLatenessAll();
+    return 0;
+  }
+  if (argc > 1 && std::string(argv[1]) == "repeat") {
+    benchmarkRepeatingAll();
+    return 0;
+  }
+  if (argc > 1 && std::string(argv[1]) == "coalesce") {
+    benchmarkCoalescingAll();
+    return 0;
+  }
+  if (argc > 1 && std::string(argv[1]) == "producers") {
+    benchmarkProducers();
+    return 0;
+  }
+
   Timer timer;
 
   // 添加一次性定时器
@@ -112,13 +1307,27 @@ int main() {
                  []() { std::cout << "一次性定时器触发！" << std::endl; });
 
   // 添加周期性定时器
-  std::cout << "添加周期性定时器（每1秒执行一次）" << std::endl;
-  timer.addRepeatingTimer(
+  std::cout << "添加周期性定时器（每1秒执行一次，3.5秒后取消）" << std::endl;
+  Timer::TimerId repeating = timer.addRepeatingTimer(
       1000, []() { std::cout << "周期性定时器触发！" << std::endl; });
 
+  // 取消的定时器不会执行
+  Timer::TimerId cancelled = timer.addTimer(1500, []() { std::cout << "不应该出现" << std::endl; });
+  timer.cancel(cancelled);
+
+  // 时间轮后端，10ms 一个 tick；1.5 秒的超时被推迟到 4 秒
+  Timer wheelTimer(TimerBackend::Wheel, std::chrono::milliseconds(10));
+  Timer::TimerId timeout =
+      wheelTimer.addTimer(1500, []() { std::cout << "时间轮定时器触发（已推迟到4秒）！" << std::endl; });
+  wheelTimer.reschedule(timeout, 4000);
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(3500));
+  timer.cancel(repeating);
+
   // 等待5秒后退出
-  std::this_thread::sleep_for(std::chrono::seconds(5));
+  std::this_thread::sleep_for(std::chrono::milliseconds(1500));
   std::cout << "程序退出" << std::endl;
 
   return 0;
-}
\ No newline at end of file
+}
+#endif
@@ -155,7 +155,7 @@ public:
     }
 };
 
-
+#ifndef NO_MAIN
 int main() {
     const size_t THREAD_COUNT = 4;
     ThreadPool pool(THREAD_COUNT);
@@ -205,4 +205,5 @@ int main() {
     std::cout << "Time taken: " << duration.count() << "ms" << std::endl;
 
     return 0;
-}
\ No newline at end of file
+}
+#endif
@@ -2,155 +2,345 @@
 #include <cstdlib>
 #include <ctime>
 #include <climits>
-#include <limits>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <random>
 
-template<typename K, typename V>
+// Compare 带 is_transparent（如 std::less<>）时，查找类接口可直接接受
+// 与 K 可比较的其他类型，例如用 std::string_view 查 std::string 键而不构造临时 key
+template<typename K, typename V, typename Compare = std::less<K>>
 class SkipList {
 private:
-    struct Node {
-        K key;
-        V value;
+    struct Node;
+
+    // 各层链接。头节点只有链接部分，不构造 key/value，因此 K 不需要最小值或默认构造
+    struct Link {
         // 指向不同级别的下一个节点的指针数组
         Node** forward;
+        // span[i]: 沿第i层走到 forward[i] 跨过的第0层节点数（forward[i]为空时为到表尾的距离）
+        size_t* span;
         int level;
 
-        Node(K k, V v, int lvl) : key(k), value(v), level(lvl) {
+        explicit Link(int lvl) : level(lvl) {
             forward = new Node*[level + 1];
+            span = new size_t[level + 1];
             for (int i = 0; i <= level; i++) {
                 forward[i] = nullptr;
+                span[i] = 0;
             }
         }
 
-        ~Node() {
+        ~Link() {
             delete[] forward;
+            delete[] span;
         }
     };
 
-    Node* head;      // 头节点
+    struct Node : Link {
+        K key;
+        V value;
+
+        // key 与 value 直接在节点内构造，右值会被移动进来
+        template<typename KK, typename... Args>
+        Node(int lvl, KK&& k, Args&&... args)
+            : Link(lvl), key(std::forward<KK>(k)), value(std::forward<Args>(args)...) {}
+    };
+
+    template<typename C, typename = void>
+    struct IsTransparent : std::false_type {};
+    template<typename C>
+    struct IsTransparent<C, std::void_t<typename C::is_transparent>> : std::true_type {};
+
+    // 仅在比较器透明时启用的异构查找重载
+    template<typename KK, typename C = Compare>
+    using EnableIfTransparent = std::enable_if_t<IsTransparent<C>::value && !std::is_same_v<KK, K>, int>;
+
+    Link* head;      // 头节点
     int maxLevel;    // 最大层数
     int level;       // 当前层数
     float probability; // 层数增加的概率
+    size_t length = 0; // 节点个数
+    Compare comp;      // key 比较器
 
-    // 随机生成层数
-    int randomLevel() {
-        int lvl = 1;
-        while ((float)rand()/RAND_MAX < probability && lvl < maxLevel) {
-            lvl++;
-        }
-        return lvl;
-    }
-
-public:
-    SkipList(int maxLvl = 16, float p = 0.5) 
-        : maxLevel(maxLvl), level(0), probability(p) {
-        srand(time(nullptr));
-        K minKey = std::numeric_limits<K>::min();
-        head = new Node(minKey, V(), maxLevel);
+    template<typename A, typename B>
+    bool equal(const A& a, const B& b) const {
+        return !comp(a, b) && !comp(b, a);
     }
 
-    ~SkipList() {
-        Node* current = head;
-        while (current != nullptr) {
-            Node* next = current->forward[0];
-            delete current;
-            current = next;
-        }
-    }
-
-    // 插入键值对
-    void insert(K key, V value) {
-        Node* update[maxLevel + 1];
-        Node* current = head;
-
-        // 从最高层开始查找插入位置
+    // 从最高层开始，找到每层最后一个 key 小于给定key 的节点存入 update，
+    // rank 不为空时同时记录这些节点的排名（头节点为0）；返回第0层的下一个节点
+    template<typename KK>
+    Node* findPredecessors(const KK& key, Link** update, size_t* rank) const {
+        Link* current = head;
         for (int i = level; i >= 0; i--) {
-            while (current->forward[i] != nullptr && 
-                   current->forward[i]->key < key) {
+            if (rank) rank[i] = (i == level) ? 0 : rank[i + 1];
+            while (current->forward[i] != nullptr &&
+                   comp(current->forward[i]->key, key)) {
+                if (rank) rank[i] += current->span[i];
                 current = current->forward[i];
             }
-            update[i] = current;
+            if (update) update[i] = current;
         }
-        current = current->forward[0];
+        return current->forward[0];
+    }
+
+    template<typename KK>
+    Node* findNode(const KK& key) const {
+        Node* node = findPredecessors(key, nullptr, nullptr);
+        return (node != nullptr && equal(node->key, key)) ? node : nullptr;
+    }
+
+    // key 已存在时 overwrite 为真则用参数重新赋值，否则保持原值不动
+    template<typename KK, typename... Args>
+    std::pair<Node*, bool> emplaceImpl(bool overwrite, KK&& key, Args&&... args) {
+        Link* update[maxLevel + 1];
+        size_t rank[maxLevel + 1];  // update[i] 的排名（头节点为0）
+        Node* current = findPredecessors(key, update, rank);
 
         // 如果key已存在，更新value
-        if (current != nullptr && current->key == key) {
-            current->value = value;
-            return;
+        if (current != nullptr && equal(current->key, key)) {
+            if (overwrite) {
+                if constexpr (sizeof...(Args) == 1) {
+                    current->value = (std::forward<Args>(args), ...);
+                } else {
+                    current->value = V(std::forward<Args>(args)...);
+                }
+            }
+            return {current, false};
         }
 
         // 生成随机层数
         int newLevel = randomLevel();
         if (newLevel > level) {
             for (int i = level + 1; i <= newLevel; i++) {
+                rank[i] = 0;
                 update[i] = head;
+                head->span[i] = length;
             }
             level = newLevel;
         }
 
         // 创建新节点
-        Node* newNode = new Node(key, value, newLevel);
+        Node* newNode = new Node(newLevel, std::forward<KK>(key), std::forward<Args>(args)...);
 
-        // 更新前向指针
+        // 更新前向指针和跨度
         for (int i = 0; i <= newLevel; i++) {
             newNode->forward[i] = update[i]->forward[i];
             update[i]->forward[i] = newNode;
+            newNode->span[i] = update[i]->span[i] - (rank[0] - rank[i]);
+            update[i]->span[i] = rank[0] - rank[i] + 1;
+        }
+        // 更高层跨过了新节点，跨度加一
+        for (int i = newLevel + 1; i <= level; i++) {
+            update[i]->span[i]++;
         }
+        length++;
+        return {newNode, true};
     }
 
-    // 查找键对应的值
-    bool search(K key, V& value) {
-        Node* current = head;
+    template<typename KK>
+    bool removeImpl(const KK& key) {
+        Link* update[maxLevel + 1];
+        Node* current = findPredecessors(key, update, nullptr);
 
-        // 从最高层开始查找
-        for (int i = level; i >= 0; i--) {
-            while (current->forward[i] != nullptr && 
-                   current->forward[i]->key < key) {
-                current = current->forward[i];
+        // 如果找到key，删除节点
+        if (current != nullptr && equal(current->key, key)) {
+            for (int i = 0; i <= level; i++) {
+                if (update[i]->forward[i] == current) {
+                    update[i]->span[i] += current->span[i] - 1;
+                    update[i]->forward[i] = current->forward[i];
+                } else {
+                    update[i]->span[i]--;
+                }
             }
-        }
 
-        current = current->forward[0];
+            // 更新level
+            while (level > 0 && head->forward[level] == nullptr) {
+                level--;
+            }
 
-        if (current != nullptr && current->key == key) {
-            value = current->value;
+            delete current;
+            length--;
             return true;
         }
         return false;
     }
 
-    // 删除键值对
-    bool remove(K key) {
-        Node* update[maxLevel + 1];
-        Node* current = head;
-
-        // 从最高层开始查找
+    template<typename KK>
+    long rankImpl(const KK& key) const {
+        Link* current = head;
+        size_t traversed = 0;
         for (int i = level; i >= 0; i--) {
-            while (current->forward[i] != nullptr && 
-                   current->forward[i]->key < key) {
+            while (current->forward[i] != nullptr &&
+                   !comp(key, current->forward[i]->key)) {
+                traversed += current->span[i];
                 current = current->forward[i];
             }
-            update[i] = current;
+            if (current != head && equal(static_cast<Node*>(current)->key, key)) {
+                return static_cast<long>(traversed) - 1;
+            }
         }
-        current = current->forward[0];
+        return -1;
+    }
 
-        // 如果找到key，删除节点
-        if (current != nullptr && current->key == key) {
-            for (int i = 0; i <= level; i++) {
-                if (update[i]->forward[i] != current) {
-                    break;
-                }
-                update[i]->forward[i] = current->forward[i];
+    // 按跨度向下逼近，定位排名为r（从0开始）的节点
+    Node* nodeAt(size_t r) const {
+        if (r >= length) return nullptr;
+        Link* current = head;
+        size_t traversed = 0;
+        for (int i = level; i >= 0; i--) {
+            while (current->forward[i] != nullptr &&
+                   traversed + current->span[i] <= r + 1) {
+                traversed += current->span[i];
+                current = current->forward[i];
             }
+            if (traversed == r + 1) return static_cast<Node*>(current);
+        }
+        return nullptr;
+    }
 
-            // 更新level
-            while (level > 0 && head->forward[level] == nullptr) {
-                level--;
-            }
+    // 随机生成层数
+    int randomLevel() {
+        int lvl = 1;
+        while ((float)rand()/RAND_MAX < probability && lvl < maxLevel) {
+            lvl++;
+        }
+        return lvl;
+    }
 
+public:
+    // 沿第0层顺序遍历的迭代器，用于有序导出（如 memtable 落盘、范围查询）
+    class Iterator {
+    public:
+        explicit Iterator(Node* n) : node(n) {}
+        bool valid() const { return node != nullptr; }
+        const K& key() const { return node->key; }
+        const V& value() const { return node->value; }
+        void next() { node = node->forward[0]; }
+    private:
+        Node* node;
+    };
+
+    SkipList(int maxLvl = 16, float p = 0.5, const Compare& cmp = Compare())
+        : maxLevel(maxLvl), level(0), probability(p), comp(cmp) {
+        srand(time(nullptr));
+        head = new Link(maxLevel);
+    }
+
+    ~SkipList() {
+        Node* current = head->forward[0];
+        while (current != nullptr) {
+            Node* next = current->forward[0];
             delete current;
-            return true;
+            current = next;
         }
-        return false;
+        delete head;
+    }
+
+    SkipList(const SkipList&) = delete;
+    SkipList& operator=(const SkipList&) = delete;
+
+    // 插入键值对，key已存在时覆盖value；传右值时直接移动进节点
+    void insert(const K& key, const V& value) { emplaceImpl(true, key, value); }
+    void insert(const K& key, V&& value) { emplaceImpl(true, key, std::move(value)); }
+    void insert(K&& key, const V& value) { emplaceImpl(true, std::move(key), value); }
+    void insert(K&& key, V&& value) { emplaceImpl(true, std::move(key), std::move(value)); }
+
+    // 用 args 原地构造 value；key 已存在时不做任何修改并返回 false
+    template<typename... Args>
+    bool emplace(const K& key, Args&&... args) {
+        return emplaceImpl(false, key, std::forward<Args>(args)...).second;
+    }
+    template<typename... Args>
+    bool emplace(K&& key, Args&&... args) {
+        return emplaceImpl(false, std::move(key), std::forward<Args>(args)...).second;
+    }
+
+    // 查找键对应的值
+    bool search(const K& key, V& value) const {
+        Node* node = findNode(key);
+        if (node == nullptr) return false;
+        value = node->value;
+        return true;
+    }
+    template<typename KK, EnableIfTransparent<KK> = 0>
+    bool search(const KK& key, V& value) const {
+        Node* node = findNode(key);
+        if (node == nullptr) return false;
+        value = node->value;
+        return true;
+    }
+
+    // 返回指向节点内 value 的指针，不拷贝；不存在返回 nullptr
+    V* find(const K& key) {
+        Node* node = findNode(key);
+        return node ? &node->value : nullptr;
+    }
+    template<typename KK, EnableIfTransparent<KK> = 0>
+    V* find(const KK& key) {
+        Node* node = findNode(key);
+        return node ? &node->value : nullptr;
+    }
+    const V* find(const K& key) const {
+        Node* node = findNode(key);
+        return node ? &node->value : nullptr;
+    }
+    template<typename KK, EnableIfTransparent<KK> = 0>
+    const V* find(const KK& key) const {
+        Node* node = findNode(key);
+        return node ? &node->value : nullptr;
+    }
+
+    // 删除键值对
+    bool remove(const K& key) { return removeImpl(key); }
+    template<typename KK, EnableIfTransparent<KK> = 0>
+    bool remove(const KK& key) { return removeImpl(key); }
+
+    size_t size() const { return length; }
+
+    // 返回key的排名（从0开始，按key升序），不存在返回-1
+    long rank(const K& key) const { return rankImpl(key); }
+    template<typename KK, EnableIfTransparent<KK> = 0>
+    long rank(const KK& key) const { return rankImpl(key); }
+
+    // 取排名为r（从0开始）的键值对
+    bool at(size_t r, K& key, V& value) const {
+        Node* current = nodeAt(r);
+        if (current == nullptr) return false;
+        key = current->key;
+        value = current->value;
+        return true;
+    }
+
+    // 取排名在 [a, b] 内的键值对（闭区间，与 Redis ZRANGE 一致）
+    std::vector<std::pair<K, V>> rangeByRank(size_t a, size_t b) const {
+        std::vector<std::pair<K, V>> result;
+        if (a > b || a >= length) return result;
+        b = std::min(b, length - 1);
+        result.reserve(b - a + 1);
+        Node* current = nodeAt(a);
+        for (size_t r = a; r <= b; r++) {
+            result.emplace_back(current->key, current->value);
+            current = current->forward[0];
+        }
+        return result;
+    }
+
+    Iterator begin() const { return Iterator(head->forward[0]); }
+
+    // 定位到第一个 key >= 给定key 的节点
+    Iterator lowerBound(const K& key) const {
+        return Iterator(findPredecessors(key, nullptr, nullptr));
+    }
+    template<typename KK, EnableIfTransparent<KK> = 0>
+    Iterator lowerBound(const KK& key) const {
+        return Iterator(findPredecessors(key, nullptr, nullptr));
     }
 
     // 打印跳表
@@ -167,7 +357,69 @@ public:
     }
 };
 
-int main() {
+#ifndef NO_MAIN
+// 排行榜压测：key 为 (分数, 成员id)，同分按 id 排序，与 Redis 有序集合的排序规则一致
+void benchmarkLeaderboard(size_t members) {
+    using Score = std::pair<long long, long long>;
+    SkipList<Score, int> board(32, 0.25);
+    std::mt19937_64 rng(42);
+    std::vector<Score> keys(members);
+    for (size_t i = 0; i < members; i++) {
+        keys[i] = {static_cast<long long>(rng() % 1000000000), static_cast<long long>(i)};
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (auto& k : keys) board.insert(k, 0);
+    auto elapsed = [&start]() {
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        start = std::chrono::steady_clock::now();
+        return secs;
+    };
+    std::cout << members << " members, insert: " << elapsed() << "s" << std::endl;
+
+    const size_t queries = 1000000;
+    long long checksum = 0;
+    for (size_t i = 0; i < queries; i++) {
+        checksum += board.rank(keys[rng() % members]);
+    }
+    double secs = elapsed();
+    std::cout << "rank(key): " << static_cast<long long>(queries / secs) << " ops/s" << std::endl;
+
+    Score key;
+    int value;
+    for (size_t i = 0; i < queries; i++) {
+        board.at(rng() % members, key, value);
+        checksum += key.second;
+    }
+    secs = elapsed();
+    std::cout << "at(rank): " << static_cast<long long>(queries / secs) << " ops/s" << std::endl;
+
+    const size_t pages = 100000;
+    for (size_t i = 0; i < pages; i++) {
+        size_t from = rng() % members;
+        checksum += board.rangeByRank(from, from + 99).size();
+    }
+    secs = elapsed();
+    std::cout << "rangeByRank(100 members): " << static_cast<long long>(pages / secs) << " ops/s" << std::endl;
+
+    // 抽查 rank 与 at 互逆
+    for (int i = 0; i < 1000; i++) {
+        size_t r = rng() % members;
+        board.at(r, key, value);
+        if (board.rank(key) != static_cast<long>(r)) {
+            std::cout << "rank mismatch at " << r << std::endl;
+            break;
+        }
+    }
+    std::cout << "(checksum " << checksum << ")" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && std::string(argv[1]) == "bench") {
+        benchmarkLeaderboard(10000000);
+        return 0;
+    }
+
     // 创建跳表
     SkipList<int, std::string> skipList(4, 0.5);
     
@@ -192,6 +444,30 @@ int main() {
     skipList.remove(6);
     std::cout << "\nAfter removing 6:" << std::endl;
     skipList.display();
-    
+
+    // 排名查询
+    std::cout << "\nRank of 9: " << skipList.rank(9) << std::endl;
+    int key;
+    if (skipList.at(1, key, value)) {
+        std::cout << "Rank 1: " << key << ":" << value << std::endl;
+    }
+    std::cout << "Rank [0, 2]:";
+    for (auto& kv : skipList.rangeByRank(0, 2)) {
+        std::cout << " " << kv.first << ":" << kv.second;
+    }
+    std::cout << std::endl << std::endl;
+
+    // 字符串键：透明比较器下直接用 string_view 查找，不构造临时 std::string
+    SkipList<std::string, std::string, std::less<>> dict;
+    std::string longKey(64, 'k');
+    dict.insert(std::move(longKey), std::string("moved"));  // key 和 value 都被移动进节点
+    dict.emplace("apple", 3, 'a');                          // value 原地构造为 "aaa"
+    std::string_view view = "apple";
+    if (const std::string* v = dict.find(view)) {
+        std::cout << "Found apple by string_view, value = " << *v << std::endl;
+    }
+    std::cout << "Rank of apple: " << dict.rank(view) << ", size = " << dict.size() << std::endl;
+
     return 0;
-}
\ No newline at end of file
+}
+#endif